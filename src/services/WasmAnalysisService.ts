@@ -6,16 +6,178 @@ interface WasmModule {
   processAudioFrames: (audioData: number[], frameLength: number, hopSize: number) => number[][];
   calculatePitch: (audioData: number[], sampleRate: number) => number;
   calculateSpectralCentroid: (audioData: number[], sampleRate: number) => number;
+  featureConfigHash: (frameLength: number, hopSize: number) => string;
   dtw_distance: (seq1: number[][], seq2: number[][], bandWidth?: number) => { distance: number; normalized_distance: number };
-  dtw_align: (seq1: number[][], seq2: number[][], bandWidth?: number) => { distance: number; normalized_distance: number; path: number[][] };
-  createHMM: (numStates: number, numObservations: number) => void;
-  setTransition: (fromState: number, toState: number, prob: number) => void;
-  setEmission: (state: number, observation: number, prob: number) => void;
-  setInitial: (state: number, prob: number) => void;
-  viterbi: (observations: number[]) => number[];
-  forward: (observations: number[]) => number;
-  backward: (observations: number[]) => number;
+  dtw_align: (seq1: number[][], seq2: number[][], bandWidth?: number) => { distance: number; normalized_distance: number; path: Int32Array };
+  dtw_align_pattern: (seq1: number[][], seq2: number[][], stepPattern: DTWStepPattern, windowType: DTWWindow, windowParam: number) => { distance: number; normalized_distance: number; path: Int32Array };
+  dtw_upload_sequence: (seq: number[][]) => number;
+  dtw_upload_flat: (data: Float64Array, frames: number, dims: number) => number;
+  dtw_release_sequence: (handle: number) => void;
+  dtw_set_preprocessing: (handle: number, mode: DTWPreprocessing) => boolean;
+  dtw_batch: (queryHandle: number, referenceHandles: Int32Array, bandWidth: number, maxDistance: number, returnPaths: boolean) => { distances: Float64Array; paths?: Int32Array[] };
+  dtw_align_words: (queryHandle: number, referenceHandle: number, wordBoundaries: Int32Array, bandWidth: number) => { distance: number; normalized_distance: number; words: WordSegment[] };
+  dtw_barycenter: (sequences: number[][][], numTemplates: number, maxIterations: number, bandWidth: number) => number[][][];
+  dtw_within_bound: (seq1: number[][], seq2: number[][], bandWidth: number, maxDistance: number) => { within_bound: boolean; distance: number; normalized_distance: number };
+  dtw_distance_parallel: (seq1: number[][], seq2: number[][], bandWidth: number) => { distance: number; normalized_distance: number };
+  dtw_subsequence: (query: number[][], series: number[][], numMatches: number) => SubsequenceMatch[];
+  feature_store_buffer: (size: number) => Uint8Array;
+  feature_store_open: () => string;
+  feature_store_info: () => ReferenceStoreInfo;
+  feature_store_lookup: (surah: number, ayah: number, word: number) => number;
+  feature_store_word_boundaries: (surah: number, ayah: number) => Int32Array;
+  feature_store_batch: (queryHandle: number, verses: Int32Array, bandWidth: number, maxDistance: number) => Float64Array;
+  DTWSession: new (referenceHandle: number, bandWidth: number) => NativeDTWSession;
+  OnlineDTW: new (reference: number[][], windowSize: number) => OnlineAligner;
+  createHMM: (numStates: number, numObservations: number) => number;
+  createHMMFromLogProbs: (numStates: number, numObservations: number, values: Float32Array) => number;
+  loadHMMModel: (bytes: Uint8Array) => number;
+  hmmModelError: () => string;
+  hmmModelInfo: (model: number) => HMMModelInfo | null;
+  setTransition: (model: number, fromState: number, toState: number, prob: number) => boolean;
+  setEmission: (model: number, state: number, observation: number, prob: number) => boolean;
+  setInitial: (model: number, state: number, prob: number) => boolean;
+  viterbi: (model: number, observations: number[]) => number[];
+  viterbiBeam: (model: number, observations: number[], beam: number, maxActive: number) => number[];
+  forward: (model: number, observations: number[]) => number;
+  backward: (model: number, observations: number[]) => number;
+  createGMMEmissions: (model: number, numComponents: number, dims: number) => boolean;
+  setGMMComponent: (model: number, state: number, component: number, weight: number, means: Float64Array, variances: Float64Array) => boolean;
+  viterbiFeatures: (model: number, frames: Float64Array, frameCount: number) => number[];
+  forwardFeatures: (model: number, frames: Float64Array, frameCount: number) => number;
+  releaseHMM: (model: number) => boolean;
   cleanupHMM: () => void;
+  StreamingViterbi: new (model: number, lag: number) => NativeStreamingViterbi;
+}
+
+// Mirrors StepPatternType / WindowType in src/wasm/dtw.h
+export enum DTWStepPattern {
+  Symmetric1 = 0,
+  Symmetric2 = 1,
+  Asymmetric = 2,
+  SymmetricP1 = 3,
+  RabinerJuangIIId = 4
+}
+
+export enum DTWWindow {
+  None = 0,
+  SakoeChiba = 1,
+  Itakura = 2
+}
+
+// Flags; ZNormDerivative is derivative DTW on z-normalized features
+export enum DTWPreprocessing {
+  None = 0,
+  ZNorm = 1,
+  Derivative = 2,
+  ZNormDerivative = 3
+}
+
+export interface SubsequenceMatch {
+  start: number;
+  end: number;
+  distance: number;
+  normalized_distance: number;
+}
+
+// Per-word result of dtw_align_words; start/end are student frames (-1 if the
+// word was not reached)
+export interface WordSegment {
+  start: number;
+  end: number;
+  average_cost: number;
+  duration_ratio: number;
+}
+
+// One diagonal-covariance Gaussian of a state's emission mixture
+export interface GMMComponent {
+  state: number;
+  component: number;
+  weight: number;
+  means: number[];
+  variances: number[];
+}
+
+export interface OnlineAligner {
+  pushFrame: (frame: number[]) => number;
+  position: () => number;
+  frameCount: () => number;
+  cost: () => number;
+  reset: () => void;
+  delete: () => void;
+}
+
+// Summary of the loaded reference feature store (src/wasm/feature_store.h)
+export interface ReferenceStoreInfo {
+  open: boolean;
+  dims: number;
+  verses: number;
+  words: number;
+  frames: number;
+  payload: 'float32' | 'int8';
+  configHash: string;
+}
+
+interface NativeDTWSession {
+  replaceSuffix: (keepRows: number, frames: Float64Array, frameCount: number) => number;
+  distance: () => number;
+  normalizedDistance: () => number;
+  queryRows: () => number;
+  path: () => Int32Array;
+  delete: () => void;
+}
+
+// Incremental alignment of a recording against one reference. Replacing the
+// recording from frame keepRows on only recomputes the replaced frames, so
+// re-reciting the last word costs as much as that word.
+export interface RealignmentSession {
+  replaceSuffix: (keepRows: number, frames: number[][]) => number;
+  distance: () => number;
+  normalizedDistance: () => number;
+  queryRows: () => number;
+  path: () => Int32Array;
+  dispose: () => void;
+}
+
+interface NativeStreamingViterbi {
+  pushObservation: (observation: number) => number[] | null;
+  pushFeatures: (frame: Float64Array) => number[] | null;
+  finish: () => number[];
+  reset: () => void;
+  frameCount: () => number;
+  committedCount: () => number;
+  bestState: () => number;
+  delete: () => void;
+}
+
+// Live phoneme decoding while recording. Each push returns the HMM states that
+// became final with that frame; they are never revised, and at most `lag`
+// frames are pending at any time. finish() returns the rest at the end.
+// pushFrame returns null if the frame was not decoded (no GMM emissions loaded,
+// or the wrong dimension); later frames are then still numbered from the last
+// decoded one.
+export interface StreamingPhonemeRecognizer {
+  pushValue: (value: number) => number[];
+  pushFrame: (mfcc: number[]) => number[] | null;
+  finish: () => number[];
+  reset: () => void;
+  committedCount: () => number;
+  currentState: () => number;
+  dispose: () => void;
+}
+
+// Discrete HMM parameters as plain probabilities; emissions[state][observation]
+export interface HMMParameters {
+  initial: number[];
+  transitions: number[][];
+  emissions: number[][];
+}
+
+// Sizes of a loaded model (src/wasm/hmm_model_file.h)
+export interface HMMModelInfo {
+  states: number;
+  observations: number;
+  components: number;
+  dims: number;
 }
 
 export interface WasmAnalysisConfig {
@@ -23,8 +185,16 @@ export interface WasmAnalysisConfig {
   hopSize?: number;
   mfccCoefficients?: number;
   dtwBandWidth?: number;
+  dtwPreprocessing?: DTWPreprocessing;
+  followWindow?: number;
   hmmStates?: number;
   hmmObservations?: number;
+  // Beam-pruned Viterbi for large phoneme models: log-probability beam below
+  // the best state (0 = exact Viterbi) and the cap on states kept per frame
+  hmmBeamWidth?: number;
+  hmmMaxActive?: number;
+  // Frames a streaming recognizer may hold back before committing a state
+  hmmStreamingLag?: number;
   loadTimeout?: number;
 }
 
@@ -33,6 +203,9 @@ export class WasmAnalysisService {
   private dtwProcessor: WasmModule | null = null;
   private hmmProcessor: WasmModule | null = null;
   private isInitialized = false;
+  private referenceHandles = new Map<string, number>();
+  private phonemeModel = -1;
+  private gmmDims = 0;
   private config: Required<WasmAnalysisConfig>;
 
   constructor(config: WasmAnalysisConfig = {}) {
@@ -41,8 +214,13 @@ export class WasmAnalysisService {
       hopSize: 512,
       mfccCoefficients: 13,
       dtwBandWidth: 50,
+      dtwPreprocessing: DTWPreprocessing.None,
+      followWindow: 64,
       hmmStates: 8,
       hmmObservations: 64,
+      hmmBeamWidth: 0,
+      hmmMaxActive: 1000,
+      hmmStreamingLag: 20,
       loadTimeout: 10000,
       ...config
     };
@@ -123,47 +301,106 @@ export class WasmAnalysisService {
     if (!this.hmmProcessor) return;
 
     try {
-      // Create HMM with phoneme states
-      this.hmmProcessor.createHMM(this.config.hmmStates, this.config.hmmObservations);
+      this.phonemeModel = this.createDefaultPhonemeModel();
+      console.log('HMM initialized successfully');
+    } catch (error) {
+      console.error('Failed to initialize HMM:', error);
+    }
+  }
 
-      // Initialize with simple phoneme model
-      // This is a simplified example - in production, you'd load trained parameters
-      
-      // Set initial probabilities (uniform distribution)
-      for (let i = 0; i < this.config.hmmStates; i++) {
-        this.hmmProcessor.setInitial(i, 1.0 / this.config.hmmStates);
+  // Simple left-to-right phoneme model; returns its handle, still editable.
+  // This is a simplified example - in production, you'd load trained parameters
+  private createDefaultPhonemeModel(): number {
+    const numStates = this.config.hmmStates;
+    const numObservations = this.config.hmmObservations;
+    const initial: number[] = [];
+    const transitions: number[][] = [];
+    const emissions: number[][] = [];
+
+    for (let i = 0; i < numStates; i++) {
+      // Initial probabilities (uniform distribution)
+      initial.push(1.0 / numStates);
+
+      // Transition probabilities (simple left-to-right model)
+      const row = new Array(numStates).fill(0);
+      row[i] = 0.7; // Self-transition
+      if (i + 1 < numStates) {
+        row[i + 1] = 0.3; // Forward transition
       }
+      transitions.push(row);
+
+      // Emission probabilities (simplified Gaussian-like distribution)
+      const mean = (i / numStates) * numObservations;
+      const variance = 10.0;
+      emissions.push(Array.from({ length: numObservations }, (_, obs) =>
+        Math.max(Math.exp(-0.5 * Math.pow(obs - mean, 2) / variance) / Math.sqrt(2 * Math.PI * variance), 1e-10)
+      ));
+    }
+    return this.loadHMMModel({ initial, transitions, emissions });
+  }
 
-      // Set transition probabilities (simple left-to-right model)
-      for (let i = 0; i < this.config.hmmStates; i++) {
-        for (let j = 0; j < this.config.hmmStates; j++) {
-          if (i === j) {
-            this.hmmProcessor.setTransition(i, j, 0.7); // Self-transition
-          } else if (j === i + 1) {
-            this.hmmProcessor.setTransition(i, j, 0.3); // Forward transition
-          } else {
-            this.hmmProcessor.setTransition(i, j, 0.0); // No other transitions
-          }
-        }
-      }
+  // Load another discrete model (e.g. one per phoneme or word) next to the
+  // default one, in one call. Returns its handle for recognizePhonemes and
+  // createStreamingRecognizer, or -1; models are immutable once used and stay
+  // loaded until releaseModel.
+  loadHMMModel(parameters: HMMParameters): number {
+    if (!this.hmmProcessor) {
+      return -1;
+    }
+    const numStates = parameters.initial.length;
+    const numObservations = numStates > 0 ? parameters.emissions[0].length : 0;
+
+    // initial, transitions [from][to] and emissions [obs][state] as log probabilities
+    const values = new Float32Array(numStates + numStates * numStates + numObservations * numStates);
+    const logProb = (p: number) => (p > 0 ? Math.log(p) : -Infinity);
+    parameters.initial.forEach((p, state) => { values[state] = logProb(p); });
+    parameters.transitions.forEach((row, from) =>
+      row.forEach((p, to) => { values[numStates + from * numStates + to] = logProb(p); })
+    );
+    const emissionsOffset = numStates + numStates * numStates;
+    parameters.emissions.forEach((row, state) =>
+      row.forEach((p, obs) => { values[emissionsOffset + obs * numStates + state] = logProb(p); })
+    );
+
+    const model = this.hmmProcessor.createHMMFromLogProbs(numStates, numObservations, values);
+    if (model < 0) {
+      console.error('Invalid HMM model:', this.hmmProcessor.hmmModelError());
+    }
+    return model;
+  }
 
-      // Set emission probabilities (simplified Gaussian-like distribution)
-      for (let state = 0; state < this.config.hmmStates; state++) {
-        for (let obs = 0; obs < this.config.hmmObservations; obs++) {
-          // Simple Gaussian-like emission probability
-          const mean = (state / this.config.hmmStates) * this.config.hmmObservations;
-          const variance = 10.0;
-          const prob = Math.exp(-0.5 * Math.pow(obs - mean, 2) / variance) / Math.sqrt(2 * Math.PI * variance);
-          this.hmmProcessor.setEmission(state, obs, Math.max(prob, 1e-10));
-        }
+  // Load a binary model file, e.g. one written by train_hmm --models-dir.
+  // With asPhonemeModel it replaces the default phoneme model, and a model with
+  // GMM emissions is then used for MFCC decoding.
+  async loadHMMModelFile(url: string, asPhonemeModel = false): Promise<number> {
+    if (!this.hmmProcessor) {
+      return -1;
+    }
+    try {
+      const response = await fetch(url);
+      if (!response.ok) {
+        throw new Error(`HTTP ${response.status}`);
       }
-
-      console.log('HMM initialized successfully');
+      const model = this.hmmProcessor.loadHMMModel(new Uint8Array(await response.arrayBuffer()));
+      if (model < 0) {
+        throw new Error(this.hmmProcessor.hmmModelError());
+      }
+      if (asPhonemeModel) {
+        this.hmmProcessor.releaseHMM(this.phonemeModel);
+        this.phonemeModel = model;
+        this.gmmDims = this.hmmProcessor.hmmModelInfo(model)?.dims ?? 0;
+      }
+      return model;
     } catch (error) {
-      console.error('Failed to initialize HMM:', error);
+      console.error('Error loading HMM model:', error);
+      return -1;
     }
   }
 
+  releaseModel(model: number): void {
+    this.hmmProcessor?.releaseHMM(model);
+  }
+
   async extractAdvancedFeatures(audioBuffer: AudioBuffer): Promise<{
     mfcc: number[][];
     pitch: number[];
@@ -214,10 +451,11 @@ export class WasmAnalysisService {
     return features;
   }
 
+  // The alignment path is interleaved frame pairs: [i0, j0, i1, j1, ...]
   async alignAudioSequences(sequence1: number[][], sequence2: number[][]): Promise<{
     distance: number;
     normalizedDistance: number;
-    alignment?: number[][];
+    alignment?: Int32Array;
   }> {
     try {
       if (this.dtwProcessor) {
@@ -241,7 +479,231 @@ export class WasmAnalysisService {
     }
   }
 
-  async recognizePhonemes(observations: number[]): Promise<{
+  // Upload a feature sequence to the DTW module once and get a handle to it.
+  // Frames are packed into one Float64Array so they cross into WASM in a single copy.
+  uploadSequence(sequence: number[][]): number {
+    if (!this.dtwProcessor || sequence.length === 0) {
+      return -1;
+    }
+    const dims = sequence[0].length;
+    const flat = new Float64Array(sequence.length * dims);
+    sequence.forEach((frame, i) => flat.set(frame, i * dims));
+    const handle = this.dtwProcessor.dtw_upload_flat(flat, sequence.length, dims);
+    this.applyPreprocessing(handle);
+    return handle;
+  }
+
+  // Preprocessing used whenever the handle is aligned. Normalized frames are
+  // computed once inside the module and kept with the handle. Query and
+  // reference handles should use the same mode.
+  setSequencePreprocessing(handle: number, mode: DTWPreprocessing): boolean {
+    return this.dtwProcessor?.dtw_set_preprocessing(handle, mode) ?? false;
+  }
+
+  private applyPreprocessing(handle: number): void {
+    if (handle >= 0 && this.config.dtwPreprocessing !== DTWPreprocessing.None) {
+      this.setSequencePreprocessing(handle, this.config.dtwPreprocessing);
+    }
+  }
+
+  releaseSequence(handle: number): void {
+    this.dtwProcessor?.dtw_release_sequence(handle);
+  }
+
+  // Align one uploaded query against many uploaded references in one call.
+  // References beyond maxDistance (if given) come back as Infinity.
+  alignBatch(queryHandle: number, referenceHandles: number[], maxDistance = Infinity, returnPaths = false): {
+    distances: Float64Array;
+    paths?: Int32Array[];
+  } {
+    if (!this.dtwProcessor) {
+      return { distances: new Float64Array(referenceHandles.length).fill(Infinity) };
+    }
+    return this.dtwProcessor.dtw_batch(
+      queryHandle,
+      Int32Array.from(referenceHandles),
+      this.config.dtwBandWidth,
+      maxDistance,
+      returnPaths
+    );
+  }
+
+  // Fetch the precomputed reference feature store and open it inside the DTW
+  // module. The file is copied into WASM memory once; verses and words are then
+  // decoded on demand by getReferenceHandle.
+  async loadReferenceStore(url: string): Promise<ReferenceStoreInfo | null> {
+    if (!this.dtwProcessor) {
+      return null;
+    }
+    try {
+      const response = await fetch(url);
+      if (!response.ok) {
+        throw new Error(`HTTP ${response.status}`);
+      }
+      const bytes = new Uint8Array(await response.arrayBuffer());
+
+      this.referenceHandles.forEach(handle => this.releaseSequence(handle));
+      this.referenceHandles.clear();
+
+      // The view is only valid until the next WASM allocation, so fill it right away
+      this.dtwProcessor.feature_store_buffer(bytes.length).set(bytes);
+      const error = this.dtwProcessor.feature_store_open();
+      if (error) {
+        throw new Error(error);
+      }
+
+      const info = this.dtwProcessor.feature_store_info();
+      const expectedHash = this.audioProcessor?.featureConfigHash(this.config.bufferSize, this.config.hopSize);
+      if (expectedHash && expectedHash !== info.configHash) {
+        console.warn(`Reference store was built with a different feature configuration (${info.configHash}, expected ${expectedHash})`);
+      }
+      return info;
+    } catch (error) {
+      console.error('Error loading reference feature store:', error);
+      return null;
+    }
+  }
+
+  // Sequence handle for a whole verse (word omitted) or a single word from the
+  // reference store; -1 if it is not in the store. Handles are cached.
+  getReferenceHandle(surah: number, ayah: number, word = 0): number {
+    if (!this.dtwProcessor) {
+      return -1;
+    }
+    const key = `${surah}:${ayah}:${word}`;
+    const cached = this.referenceHandles.get(key);
+    if (cached !== undefined) {
+      return cached;
+    }
+    const handle = this.dtwProcessor.feature_store_lookup(surah, ayah, word);
+    if (handle >= 0) {
+      this.applyPreprocessing(handle);
+      this.referenceHandles.set(key, handle);
+    }
+    return handle;
+  }
+
+  // First reference frame of each word in a verse, followed by the verse length
+  getReferenceWordBoundaries(surah: number, ayah: number): Int32Array {
+    return this.dtwProcessor?.feature_store_word_boundaries(surah, ayah) ?? new Int32Array(0);
+  }
+
+  // DTW distance from an uploaded recording to each [surah, ayah] verse of the
+  // reference store. An int8 store is searched directly on its quantized frames.
+  searchReferenceVerses(queryHandle: number, verses: Array<[number, number]>, maxDistance = Infinity): Float64Array {
+    if (!this.dtwProcessor) {
+      return new Float64Array(verses.length).fill(Infinity);
+    }
+    return this.dtwProcessor.feature_store_batch(
+      queryHandle,
+      Int32Array.from(verses.flat()),
+      this.config.dtwBandWidth,
+      maxDistance
+    );
+  }
+
+  // Align an uploaded recording against a verse from the reference store and
+  // score it word by word. Segmentation runs in WASM on the store's word
+  // boundaries, so only the per-word results come back.
+  scoreWords(queryHandle: number, surah: number, ayah: number): {
+    distance: number;
+    normalizedDistance: number;
+    words: WordSegment[];
+  } {
+    const referenceHandle = this.getReferenceHandle(surah, ayah);
+    if (!this.dtwProcessor || referenceHandle < 0) {
+      return { distance: Infinity, normalizedDistance: Infinity, words: [] };
+    }
+    const result = this.dtwProcessor.dtw_align_words(
+      queryHandle,
+      referenceHandle,
+      this.getReferenceWordBoundaries(surah, ayah),
+      this.config.dtwBandWidth
+    );
+    return {
+      distance: result.distance,
+      normalizedDistance: result.normalized_distance,
+      words: result.words
+    };
+  }
+
+  createRealignmentSession(referenceHandle: number): RealignmentSession | null {
+    if (!this.dtwProcessor) {
+      return null;
+    }
+    const session = new this.dtwProcessor.DTWSession(referenceHandle, this.config.dtwBandWidth);
+    return {
+      replaceSuffix: (keepRows, frames) => {
+        const dims = frames.length > 0 ? frames[0].length : 0;
+        const flat = new Float64Array(frames.length * dims);
+        frames.forEach((frame, i) => flat.set(frame, i * dims));
+        return session.replaceSuffix(keepRows, flat, frames.length);
+      },
+      distance: () => session.distance(),
+      normalizedDistance: () => session.normalizedDistance(),
+      queryRows: () => session.queryRows(),
+      path: () => session.path(),
+      dispose: () => session.delete()
+    };
+  }
+
+  // Average several reference reciters of one verse into one or two DTW
+  // barycenter templates, so attempts are compared against those instead of every Qari
+  async buildReferenceTemplates(references: number[][][], numTemplates = 1, maxIterations = 10): Promise<number[][][]> {
+    try {
+      if (this.dtwProcessor && references.length > 0) {
+        return this.dtwProcessor.dtw_barycenter(references, numTemplates, maxIterations, this.config.dtwBandWidth);
+      }
+    } catch (error) {
+      console.error('Error building DBA templates:', error);
+    }
+    return references.slice(0, 1);
+  }
+
+  // Pass/fail check for practice mode. Alignments that cannot finish under the
+  // threshold are abandoned early, so wrong-verse attempts are rejected cheaply.
+  async isWithinDistance(sequence1: number[][], sequence2: number[][], maxNormalizedDistance: number): Promise<boolean> {
+    try {
+      if (this.dtwProcessor) {
+        const maxDistance = maxNormalizedDistance * Math.max(sequence1.length, sequence2.length);
+        return this.dtwProcessor.dtw_within_bound(sequence1, sequence2, this.config.dtwBandWidth, maxDistance).within_bound;
+      }
+      return this.dtwFallback(sequence1, sequence2).normalizedDistance <= maxNormalizedDistance;
+    } catch (error) {
+      console.error('Error in bounded DTW:', error);
+      return false;
+    }
+  }
+
+  // Find where a reference (e.g. one verse) occurs inside a longer recording
+  async locateInRecording(recording: number[][], reference: number[][], maxMatches = 1): Promise<SubsequenceMatch[]> {
+    try {
+      if (this.dtwProcessor) {
+        return this.dtwProcessor.dtw_subsequence(reference, recording, maxMatches);
+      }
+    } catch (error) {
+      console.error('Error in subsequence DTW:', error);
+    }
+    return [];
+  }
+
+  // Create an online aligner that tracks the reciter's position in the reference
+  // frame by frame while recording. pushFrame returns -1 for a frame whose length
+  // differs from the reference frames and keeps tracking. Callers must delete()
+  // it when done.
+  createFollowAligner(reference: number[][]): OnlineAligner | null {
+    if (!this.dtwProcessor || reference.length === 0) {
+      return null;
+    }
+    try {
+      return new this.dtwProcessor.OnlineDTW(reference, this.config.followWindow);
+    } catch (error) {
+      console.error('Error creating online aligner:', error);
+      return null;
+    }
+  }
+
+  async recognizePhonemes(observations: number[], model = this.phonemeModel): Promise<{
     states: number[];
     probability: number;
   }> {
@@ -252,8 +714,10 @@ export class WasmAnalysisService {
           Math.max(0, Math.min(this.config.hmmObservations - 1, Math.floor(obs * this.config.hmmObservations)))
         );
 
-        const states = this.hmmProcessor.viterbi(discreteObs);
-        const probability = Math.exp(this.hmmProcessor.forward(discreteObs));
+        const states = this.config.hmmBeamWidth > 0
+          ? this.hmmProcessor.viterbiBeam(model, discreteObs, this.config.hmmBeamWidth, this.config.hmmMaxActive)
+          : this.hmmProcessor.viterbi(model, discreteObs);
+        const probability = Math.exp(this.hmmProcessor.forward(model, discreteObs));
 
         return { states, probability };
       } else {
@@ -269,6 +733,63 @@ export class WasmAnalysisService {
     }
   }
 
+  // pushValue takes the same normalized value as recognizePhonemes (e.g. the
+  // spectral centroid), pushFrame an MFCC frame once GMM emissions are loaded
+  createStreamingRecognizer(lag = this.config.hmmStreamingLag, model = this.phonemeModel): StreamingPhonemeRecognizer | null {
+    if (!this.hmmProcessor) {
+      return null;
+    }
+    const session = new this.hmmProcessor.StreamingViterbi(model, lag);
+    const observations = this.config.hmmObservations;
+    return {
+      // The value is clamped into range, so the observation is always decoded
+      pushValue: value => session.pushObservation(Math.max(0, Math.min(observations - 1, Math.floor(value * observations)))) ?? [],
+      pushFrame: mfcc => this.gmmDims > 0 ? session.pushFeatures(Float64Array.from(mfcc.slice(0, this.gmmDims))) : null,
+      finish: () => session.finish(),
+      reset: () => session.reset(),
+      committedCount: () => session.committedCount(),
+      currentState: () => session.bestState(),
+      dispose: () => session.delete()
+    };
+  }
+
+  // Install continuous emissions for the phoneme HMM: a diagonal-covariance
+  // mixture per state over MFCC frames (dims = 13, or 26 with deltas). Once
+  // loaded, analyzeRecitationWithWasm decodes MFCC frames instead of the
+  // quantized spectral centroid. Models cannot change once used, so this
+  // builds a new phoneme model and replaces the current one.
+  loadGMMEmissions(numComponents: number, dims: number, components: GMMComponent[]): boolean {
+    if (!this.hmmProcessor) {
+      return false;
+    }
+    const hmm = this.hmmProcessor;
+    const model = this.createDefaultPhonemeModel();
+    const loaded = hmm.createGMMEmissions(model, numComponents, dims) && components.every(c =>
+      hmm.setGMMComponent(model, c.state, c.component, c.weight, Float64Array.from(c.means), Float64Array.from(c.variances))
+    );
+    if (!loaded) {
+      hmm.releaseHMM(model);
+      return false;
+    }
+    hmm.releaseHMM(this.phonemeModel);
+    this.phonemeModel = model;
+    this.gmmDims = dims;
+    return true;
+  }
+
+  // Phoneme decoding on MFCC frames with the GMM emissions
+  recognizePhonemesFromFeatures(frames: number[][]): { states: number[]; probability: number } {
+    if (!this.hmmProcessor || this.gmmDims === 0 || frames.length === 0) {
+      return { states: [], probability: 0 };
+    }
+    const dims = this.gmmDims;
+    const flat = new Float64Array(frames.length * dims);
+    frames.forEach((frame, i) => flat.set(frame.slice(0, dims), i * dims));
+    const states = this.hmmProcessor.viterbiFeatures(this.phonemeModel, flat, frames.length);
+    const probability = Math.exp(this.hmmProcessor.forwardFeatures(this.phonemeModel, flat, frames.length));
+    return { states, probability };
+  }
+
   async analyzeRecitationWithWasm(
     recordingData: RecordingData,
     referenceFeatures?: number[][]
@@ -296,7 +817,9 @@ export class WasmAnalysisService {
       }
 
       // Phoneme recognition
-      if (results.advancedFeatures.spectralCentroid.length > 0) {
+      if (this.gmmDims > 0 && results.advancedFeatures.mfcc.length > 0) {
+        results.phonemes = this.recognizePhonemesFromFeatures(results.advancedFeatures.mfcc);
+      } else if (results.advancedFeatures.spectralCentroid.length > 0) {
         results.phonemes = await this.recognizePhonemes(results.advancedFeatures.spectralCentroid);
       }
 
@@ -483,6 +1006,9 @@ export class WasmAnalysisService {
       }
     }
     
+    this.referenceHandles.clear();
+    this.phonemeModel = -1;
+    this.gmmDims = 0;
     this.audioProcessor = null;
     this.dtwProcessor = null;
     this.hmmProcessor = null;
@@ -1,19 +1,18 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <string>
+#include "audio_processor.h"
+
+#ifdef __EMSCRIPTEN__
 #include <emscripten/bind.h>
+#endif
 
 // Advanced Audio Processing for Quran Recitation Analysis
 // Based on QuranPOC implementation
 
 const double PI = 3.14159265358979323846;
 
-// MFCC Configuration
-const int NUM_MEL_FILTERS = 26;
-const int NUM_MFCC_COEFFS = 13;
-const double SAMPLE_RATE = 44100.0;
-const double PRE_EMPHASIS = 0.97;
-
 // Apply Hamming window
 std::vector<double> hamming_window(int length) {
     std::vector<double> window(length);
@@ -111,7 +110,7 @@ std::vector<double> dct(const std::vector<double>& signal, int num_coeffs) {
 }
 
 // Extract MFCC coefficients
-std::vector<double> extractMFCC(const std::vector<double>& audio_frame, int frame_length, int num_coeffs = NUM_MFCC_COEFFS) {
+std::vector<double> extractMFCC(const std::vector<double>& audio_frame, int frame_length, int num_coeffs) {
     std::vector<double> frame = audio_frame;
     
     // Pre-emphasis
@@ -145,22 +144,28 @@ std::vector<double> extractMFCC(const std::vector<double>& audio_frame, int fram
     return mfcc;
 }
 
-// Process audio frames and extract features
-emscripten::val processAudioFrames(const emscripten::val& audio_data, int frame_length, int hop_size) {
-    std::vector<double> audio = emscripten::vecFromJSArray<double>(audio_data);
+// Extract MFCCs for every frame of a signal
+std::vector<std::vector<double>> computeMFCCFrames(const std::vector<double>& audio, int frame_length, int hop_size) {
     std::vector<std::vector<double>> features;
+    if (frame_length <= 0 || hop_size <= 0) {
+        return features;
+    }
     
-    for (int i = 0; i + frame_length <= audio.size(); i += hop_size) {
+    for (size_t i = 0; i + frame_length <= audio.size(); i += hop_size) {
         std::vector<double> frame(audio.begin() + i, audio.begin() + i + frame_length);
         auto mfcc = extractMFCC(frame, frame_length);
         features.push_back(mfcc);
     }
     
-    return emscripten::val::array(features.begin(), features.end());
+    return features;
+}
+
+FeatureConfig frontEndConfig(int frame_length, int hop_size) {
+    return {SAMPLE_RATE, frame_length, hop_size, NUM_MEL_FILTERS, NUM_MFCC_COEFFS, PRE_EMPHASIS};
 }
 
 // Calculate pitch using autocorrelation
-double calculatePitch(const std::vector<double>& audio_frame, double sample_rate, double min_freq = 80.0, double max_freq = 400.0) {
+double calculatePitch(const std::vector<double>& audio_frame, double sample_rate, double min_freq, double max_freq) {
     int min_period = static_cast<int>(sample_rate / max_freq);
     int max_period = static_cast<int>(sample_rate / min_freq);
     
@@ -198,13 +203,31 @@ double calculateSpectralCentroid(const std::vector<double>& audio_frame, double
     return magnitude_sum > 0 ? weighted_sum / magnitude_sum : 0.0;
 }
 
+#ifdef __EMSCRIPTEN__
+
+// Process audio frames and extract features
+emscripten::val processAudioFrames(const emscripten::val& audio_data, int frame_length, int hop_size) {
+    std::vector<double> audio = emscripten::vecFromJSArray<double>(audio_data);
+    auto features = computeMFCCFrames(audio, frame_length, hop_size);
+    return emscripten::val::array(features.begin(), features.end());
+}
+
+// Hash of the front-end configuration used by processAudioFrames, to check a
+// reference feature store was built with the same framing and filter bank
+std::string frontEndConfigHash(int frame_length, int hop_size) {
+    return featureConfigHashHex(featureConfigHash(frontEndConfig(frame_length, hop_size)));
+}
+
 // Emscripten bindings
 EMSCRIPTEN_BINDINGS(audio_processor) {
     emscripten::function("extractMFCC", &extractMFCC);
     emscripten::function("processAudioFrames", &processAudioFrames);
+    emscripten::function("featureConfigHash", &frontEndConfigHash);
     emscripten::function("calculatePitch", &calculatePitch);
     emscripten::function("calculateSpectralCentroid", &calculateSpectralCentroid);
     
     emscripten::register_vector<double>("VectorDouble");
     emscripten::register_vector<std::vector<double>>("VectorVectorDouble");
-}
\ No newline at end of file
+}
+
+#endif // __EMSCRIPTEN__
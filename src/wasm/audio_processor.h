@@ -0,0 +1,26 @@
+#pragma once
+
+#include <vector>
+#include "feature_config.h"
+
+// Audio front end shared by the WebAssembly module (audio_processor.cpp
+// bindings) and native tools, so reference features built offline match the
+// features computed in the browser exactly.
+
+// MFCC Configuration
+const int NUM_MEL_FILTERS = 26;
+const int NUM_MFCC_COEFFS = 13;
+const double SAMPLE_RATE = 44100.0;
+const double PRE_EMPHASIS = 0.97;
+
+std::vector<double> extractMFCC(const std::vector<double>& audio_frame, int frame_length, int num_coeffs = NUM_MFCC_COEFFS);
+
+// MFCCs of every full frame of `audio`, frames starting every hop_size samples.
+// Audio is expected at SAMPLE_RATE.
+std::vector<std::vector<double>> computeMFCCFrames(const std::vector<double>& audio, int frame_length, int hop_size);
+
+// Configuration computeMFCCFrames runs with, for feature store hashing
+FeatureConfig frontEndConfig(int frame_length, int hop_size);
+
+double calculatePitch(const std::vector<double>& audio_frame, double sample_rate, double min_freq = 80.0, double max_freq = 400.0);
+double calculateSpectralCentroid(const std::vector<double>& audio_frame, double sample_rate);
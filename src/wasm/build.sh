@@ -5,6 +5,49 @@
 
 set -e
 
+# Native build for server-side batch scoring: ./build.sh native
+if [ "$1" == "native" ]; then
+    CXX=${CXX:-c++}
+    NATIVE_OUT=../../build/native
+    mkdir -p $NATIVE_OUT
+
+    echo "Compiling native DTW library with $CXX..."
+    $CXX -std=c++17 -O3 -pthread -c dtw.cpp -o $NATIVE_OUT/dtw.o
+    $CXX -std=c++17 -O3 -c dtw_quantized.cpp -o $NATIVE_OUT/dtw_quantized.o
+    $CXX -std=c++17 -O3 -c feature_store.cpp -o $NATIVE_OUT/feature_store.o
+    ar rcs $NATIVE_OUT/libbaca_dtw.a $NATIVE_OUT/dtw.o $NATIVE_OUT/dtw_quantized.o $NATIVE_OUT/feature_store.o
+
+    echo "Compiling native HMM library with $CXX..."
+    $CXX -std=c++17 -O3 -c hmm.cpp -o $NATIVE_OUT/hmm.o
+    $CXX -std=c++17 -O3 -c hmm_decoder.cpp -o $NATIVE_OUT/hmm_decoder.o
+    $CXX -std=c++17 -O3 -pthread -c hmm_registry.cpp -o $NATIVE_OUT/hmm_registry.o
+    $CXX -std=c++17 -O3 -pthread -c hmm_model_file.cpp -o $NATIVE_OUT/hmm_model_file.o
+    $CXX -std=c++17 -O3 -c gmm.cpp -o $NATIVE_OUT/gmm.o
+    $CXX -std=c++17 -O3 -pthread -c hmm_training.cpp -o $NATIVE_OUT/hmm_training.o
+    ar rcs $NATIVE_OUT/libbaca_hmm.a $NATIVE_OUT/hmm.o $NATIVE_OUT/hmm_decoder.o $NATIVE_OUT/hmm_registry.o $NATIVE_OUT/hmm_model_file.o $NATIVE_OUT/gmm.o $NATIVE_OUT/hmm_training.o
+
+    echo "Compiling reference feature builder..."
+    $CXX -std=c++17 -O3 -pthread tools/build_reference_store.cpp audio_processor.cpp \
+        -L$NATIVE_OUT -lbaca_dtw -o $NATIVE_OUT/build_reference_store
+    $CXX -std=c++17 -O3 -pthread tools/quantized_dtw_report.cpp \
+        -L$NATIVE_OUT -lbaca_dtw -o $NATIVE_OUT/quantized_dtw_report
+    $CXX -std=c++17 -O3 tools/hmm_benchmark.cpp \
+        -L$NATIVE_OUT -lbaca_hmm -o $NATIVE_OUT/hmm_benchmark
+
+    echo "Compiling HMM trainer..."
+    $CXX -std=c++17 -O3 -pthread tools/train_hmm.cpp audio_processor.cpp \
+        -L$NATIVE_OUT -lbaca_hmm -o $NATIVE_OUT/train_hmm
+
+    echo "Native libraries built successfully!"
+    echo "  - $NATIVE_OUT/libbaca_dtw.a (headers: dtw.h, dtw_quantized.h, thread_pool.h, feature_store.h)"
+    echo "  - $NATIVE_OUT/libbaca_hmm.a (headers: hmm.h, hmm_decoder.h, hmm_registry.h, hmm_fixed.h, hmm_model_file.h, gmm.h, hmm_training.h)"
+    echo "  - $NATIVE_OUT/build_reference_store"
+    echo "  - $NATIVE_OUT/quantized_dtw_report"
+    echo "  - $NATIVE_OUT/hmm_benchmark"
+    echo "  - $NATIVE_OUT/train_hmm"
+    exit 0
+fi
+
 echo "Building WebAssembly modules for advanced audio processing..."
 
 # Check if Emscripten is available
@@ -32,25 +75,41 @@ emcc audio_processor.cpp \
 
 # Compile DTW algorithm
 echo "Compiling dtw.cpp..."
-emcc dtw.cpp \
+emcc dtw.cpp dtw_quantized.cpp feature_store.cpp \
     -o ../public/wasm/dtw.js \
     -s EXPORTED_FUNCTIONS="['_computeDTW', '_dtw_distance']" \
     -s EXPORTED_RUNTIME_METHODS="['ccall', 'cwrap']" \
     -s MODULARIZE=1 \
     -s EXPORT_NAME="DTWProcessor" \
     -s ENVIRONMENT='web' \
+    -s ALLOW_MEMORY_GROWTH=1 \
     -s SINGLE_FILE=1 \
     -O3 \
     --bind
 
+# Compile multi-threaded DTW (wavefront alignment on Web Workers).
+# Needs a cross-origin isolated page (COOP/COEP headers) for SharedArrayBuffer.
+echo "Compiling dtw.cpp with pthreads..."
+emcc dtw.cpp dtw_quantized.cpp feature_store.cpp \
+    -o ../public/wasm/dtw_mt.js \
+    -s MODULARIZE=1 \
+    -s EXPORT_NAME="DTWProcessorMT" \
+    -s ENVIRONMENT='web,worker' \
+    -s PTHREAD_POOL_SIZE=navigator.hardwareConcurrency \
+    -s ALLOW_MEMORY_GROWTH=1 \
+    -pthread \
+    -O3 \
+    --bind
+
 # Compile HMM algorithm
 echo "Compiling hmm.cpp..."
-emcc hmm.cpp \
+emcc hmm.cpp hmm_decoder.cpp hmm_registry.cpp hmm_model_file.cpp gmm.cpp \
     -o ../public/wasm/hmm.js \
     -s EXPORTED_FUNCTIONS="['_viterbi', '_forward', '_backward']" \
     -s EXPORTED_RUNTIME_METHODS="['ccall', 'cwrap']" \
     -s MODULARIZE=1 \
     -s EXPORT_NAME="HMMProcessor" \
+    -s ALLOW_MEMORY_GROWTH=1 \
     -s ENVIRONMENT='web' \
     -s SINGLE_FILE=1 \
     -O3 \
@@ -60,4 +119,5 @@ echo "WebAssembly modules built successfully!"
 echo "Output files:"
 echo "  - ../public/wasm/audio_processor.js"
 echo "  - ../public/wasm/dtw.js"
+echo "  - ../public/wasm/dtw_mt.js"
 echo "  - ../public/wasm/hmm.js"
\ No newline at end of file
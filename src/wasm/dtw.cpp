@@ -2,82 +2,230 @@
 #include <cmath>
 #include <algorithm>
 #include <limits>
+#include <memory>
+#include <cstdint>
+#include "dtw.h"
+#include "dtw_step_patterns.h"
+#include "thread_pool.h"
+#include "dtw_quantized.h"
+#include "feature_store.h"
+#include "feature_config.h"
+
+#ifdef __EMSCRIPTEN__
 #include <emscripten/bind.h>
+#endif
 
 // Dynamic Time Warping for Audio Alignment
 // Based on QuranPOC implementation
 
-// Distance metrics
-enum DistanceMetric {
-    EUCLIDEAN,
-    MANHATTAN,
-    COSINE
-};
-
-// Calculate distance between two feature vectors
-double calculateDistance(const std::vector<double>& vec1, const std::vector<double>& vec2, DistanceMetric metric = EUCLIDEAN) {
-    if (vec1.size() != vec2.size()) {
-        return std::numeric_limits<double>::infinity();
-    }
+// Pack a sequence into a FeatureMatrix and precompute its per-frame norms
+FeatureMatrix toFeatureMatrix(const std::vector<std::vector<double>>& sequence) {
+    FeatureMatrix matrix;
+    matrix.rows = sequence.size();
+    matrix.dims = sequence.empty() ? 0 : sequence[0].size();
+    matrix.data.resize((size_t)matrix.rows * matrix.dims);
     
-    double distance = 0.0;
+    for (int i = 0; i < matrix.rows; i++) {
+        if ((int)sequence[i].size() != matrix.dims) {
+            matrix.uniform = false;
+        }
+        
+        double* dst = matrix.row(i);
+        for (int d = 0; d < matrix.dims && d < (int)sequence[i].size(); d++) {
+            dst[d] = sequence[i][d];
+        }
+    }
     
-    switch (metric) {
-        case EUCLIDEAN: {
-            for (size_t i = 0; i < vec1.size(); i++) {
-                double diff = vec1[i] - vec2[i];
-                distance += diff * diff;
+    matrix.updateNorms();
+    return matrix;
+}
+
+void FeatureMatrix::updateNorms() {
+    sq_norms.resize(rows);
+    norms.resize(rows);
+    for (int i = 0; i < rows; i++) {
+        const double* frame = row(i);
+        double sq_norm = 0.0;
+        for (int d = 0; d < dims; d++) {
+            sq_norm += frame[d] * frame[d];
+        }
+        sq_norms[i] = sq_norm;
+        norms[i] = sqrt(sq_norm);
+    }
+}
+
+FeatureMatrix zNormalizeFeatures(const FeatureMatrix& features) {
+    FeatureMatrix normalized = features;
+    if (!features.uniform || features.rows == 0) {
+        return normalized;
+    }
+
+    const int dims = features.dims;
+    std::vector<double> mean(dims, 0.0), sq_dev(dims, 0.0);
+    for (int i = 0; i < features.rows; i++) {
+        const double* frame = features.row(i);
+        for (int d = 0; d < dims; d++) {
+            mean[d] += frame[d];
+        }
+    }
+    for (int d = 0; d < dims; d++) {
+        mean[d] /= features.rows;
+    }
+    for (int i = 0; i < features.rows; i++) {
+        const double* frame = features.row(i);
+        for (int d = 0; d < dims; d++) {
+            sq_dev[d] += (frame[d] - mean[d]) * (frame[d] - mean[d]);
+        }
+    }
+
+    std::vector<double> inv_std(dims);
+    for (int d = 0; d < dims; d++) {
+        double std_dev = sqrt(sq_dev[d] / features.rows);
+        inv_std[d] = std_dev > 1e-9 ? 1.0 / std_dev : 1.0;
+    }
+    for (int i = 0; i < normalized.rows; i++) {
+        double* frame = normalized.row(i);
+        for (int d = 0; d < dims; d++) {
+            frame[d] = (frame[d] - mean[d]) * inv_std[d];
+        }
+    }
+
+    normalized.updateNorms();
+    return normalized;
+}
+
+FeatureMatrix derivativeFeatures(const FeatureMatrix& features) {
+    FeatureMatrix slopes = features;
+    const int n = features.rows;
+    const int dims = features.dims;
+    if (!features.uniform || n == 0) {
+        return slopes;
+    }
+
+    if (n == 1) {
+        std::fill(slopes.data.begin(), slopes.data.end(), 0.0);
+    } else if (n == 2) {
+        for (int d = 0; d < dims; d++) {
+            double slope = features.row(1)[d] - features.row(0)[d];
+            slopes.row(0)[d] = slope;
+            slopes.row(1)[d] = slope;
+        }
+    } else {
+        for (int i = 1; i < n - 1; i++) {
+            const double* prev = features.row(i - 1);
+            const double* cur = features.row(i);
+            const double* next = features.row(i + 1);
+            double* out = slopes.row(i);
+            for (int d = 0; d < dims; d++) {
+                out[d] = ((cur[d] - prev[d]) + (next[d] - prev[d]) / 2.0) / 2.0;
             }
-            return sqrt(distance);
         }
+        std::copy(slopes.row(1), slopes.row(1) + dims, slopes.row(0));
+        std::copy(slopes.row(n - 2), slopes.row(n - 2) + dims, slopes.row(n - 1));
+    }
+
+    slopes.updateNorms();
+    return slopes;
+}
+
+FeatureMatrix preprocessFeatures(const FeatureMatrix& features, int mode) {
+    if (mode & PREPROCESS_ZNORM) {
+        FeatureMatrix normalized = zNormalizeFeatures(features);
+        return (mode & PREPROCESS_DERIVATIVE) ? derivativeFeatures(normalized) : normalized;
+    }
+    if (mode & PREPROCESS_DERIVATIVE) {
+        return derivativeFeatures(features);
+    }
+    return features;
+}
+
+// Compute local distances for rows [i0, i1) of a against rows [j0, j1) of b.
+// out[(i - i0) * out_stride + (j - j0)] receives the distance between a[i] and b[j].
+// Euclidean and cosine use ||a||^2 + ||b||^2 - 2a.b, so the per-cell work is a
+// single dot product against a transposed, packed tile of b.
+void computeDistanceBlock(const FeatureMatrix& a, int i0, int i1,
+                          const FeatureMatrix& b, int j0, int j1,
+                          DistanceMetric metric, double* out, int out_stride) {
+    if (i1 <= i0 || j1 <= j0) return;
+    
+    if (!a.uniform || !b.uniform || a.dims != b.dims) {
+        for (int i = i0; i < i1; i++) {
+            std::fill(out + (size_t)(i - i0) * out_stride, out + (size_t)(i - i0) * out_stride + (j1 - j0),
+                      std::numeric_limits<double>::infinity());
+        }
+        return;
+    }
+    
+    const int dims = a.dims;
+    thread_local std::vector<double> packed;
+    packed.resize((size_t)dims * DISTANCE_TILE_COLS);
+    double acc[DISTANCE_TILE_COLS];
+    
+    for (int jt = j0; jt < j1; jt += DISTANCE_TILE_COLS) {
+        const int cols = std::min(DISTANCE_TILE_COLS, j1 - jt);
         
-        case MANHATTAN: {
-            for (size_t i = 0; i < vec1.size(); i++) {
-                distance += std::abs(vec1[i] - vec2[i]);
+        // Transpose the tile of b to dims x cols so columns are contiguous
+        for (int c = 0; c < cols; c++) {
+            const double* frame = b.row(jt + c);
+            for (int d = 0; d < dims; d++) {
+                packed[(size_t)d * DISTANCE_TILE_COLS + c] = frame[d];
             }
-            return distance;
         }
         
-        case COSINE: {
-            double dot_product = 0.0;
-            double norm1 = 0.0;
-            double norm2 = 0.0;
+        for (int i = i0; i < i1; i++) {
+            const double* x = a.row(i);
+            double* dst = out + (size_t)(i - i0) * out_stride + (jt - j0);
+            std::fill(acc, acc + cols, 0.0);
             
-            for (size_t i = 0; i < vec1.size(); i++) {
-                dot_product += vec1[i] * vec2[i];
-                norm1 += vec1[i] * vec1[i];
-                norm2 += vec2[i] * vec2[i];
+            if (metric == MANHATTAN) {
+                for (int d = 0; d < dims; d++) {
+                    const double xd = x[d];
+                    const double* p = packed.data() + (size_t)d * DISTANCE_TILE_COLS;
+                    for (int c = 0; c < cols; c++) {
+                        acc[c] += std::abs(xd - p[c]);
+                    }
+                }
+                std::copy(acc, acc + cols, dst);
+                continue;
             }
             
-            if (norm1 == 0.0 || norm2 == 0.0) {
-                return 1.0; // Maximum cosine distance
+            for (int d = 0; d < dims; d++) {
+                const double xd = x[d];
+                const double* p = packed.data() + (size_t)d * DISTANCE_TILE_COLS;
+                for (int c = 0; c < cols; c++) {
+                    acc[c] += xd * p[c];
+                }
             }
             
-            return 1.0 - (dot_product / (sqrt(norm1) * sqrt(norm2)));
+            if (metric == EUCLIDEAN) {
+                const double na = a.sq_norms[i];
+                for (int c = 0; c < cols; c++) {
+                    // Clamp tiny negative values from cancellation when a ~= b
+                    dst[c] = sqrt(std::max(0.0, na + b.sq_norms[jt + c] - 2.0 * acc[c]));
+                }
+            } else {
+                const double na = a.norms[i];
+                for (int c = 0; c < cols; c++) {
+                    const double nb = b.norms[jt + c];
+                    dst[c] = (na == 0.0 || nb == 0.0) ? 1.0 : 1.0 - acc[c] / (na * nb);
+                }
+            }
         }
     }
-    
-    return distance;
 }
 
 // DTW with Sakoe-Chiba band constraint
-struct DTWResult {
-    double distance;
-    std::vector<std::pair<int, int>> path;
-    std::vector<std::vector<double>> cost_matrix;
-};
-
 DTWResult computeDTW(const std::vector<std::vector<double>>& sequence1,
                      const std::vector<std::vector<double>>& sequence2,
-                     int band_width = -1,
-                     DistanceMetric metric = EUCLIDEAN,
-                     bool return_path = true) {
+                     int band_width,
+                     DistanceMetric metric,
+                     bool return_path) {
     
     int n = sequence1.size();
     int m = sequence2.size();
     
     if (n == 0 || m == 0) {
-        return {std::numeric_limits<double>::infinity(), {}, {}};
+        return {std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(), {}, {}};
     }
     
     // If no band width specified, use unconstrained DTW
@@ -85,64 +233,56 @@ DTWResult computeDTW(const std::vector<std::vector<double>>& sequence1,
         band_width = std::max(n, m);
     }
     
+    FeatureMatrix a = toFeatureMatrix(sequence1);
+    FeatureMatrix b = toFeatureMatrix(sequence2);
+    
     // Initialize cost matrix
     std::vector<std::vector<double>> cost_matrix(n, std::vector<double>(m, std::numeric_limits<double>::infinity()));
     
-    // Compute local distance matrix
-    std::vector<std::vector<double>> local_distances(n, std::vector<double>(m));
-    for (int i = 0; i < n; i++) {
-        for (int j = 0; j < m; j++) {
-            if (std::abs(i - j) <= band_width) {
-                local_distances[i][j] = calculateDistance(sequence1[i], sequence2[j], metric);
-            } else {
-                local_distances[i][j] = std::numeric_limits<double>::infinity();
-            }
-        }
-    }
+    // Local distances for one block of rows, restricted to the band
+    std::vector<double> local_distances((size_t)DISTANCE_TILE_ROWS * m);
     
-    // Initialize first cell
-    cost_matrix[0][0] = local_distances[0][0];
-    
-    // Fill first row
-    for (int j = 1; j < m && j <= band_width; j++) {
-        cost_matrix[0][j] = cost_matrix[0][j-1] + local_distances[0][j];
-    }
-    
-    // Fill first column
-    for (int i = 1; i < n && i <= band_width; i++) {
-        cost_matrix[i][0] = cost_matrix[i-1][0] + local_distances[i][0];
-    }
-    
-    // Fill the rest of the matrix
-    for (int i = 1; i < n; i++) {
-        int j_start = std::max(1, i - band_width);
-        int j_end = std::min(m, i + band_width + 1);
+    for (int i0 = 0; i0 < n; i0 += DISTANCE_TILE_ROWS) {
+        int i1 = std::min(n, i0 + DISTANCE_TILE_ROWS);
+        int block_start = std::max(0, i0 - band_width);
+        int block_end = std::min(m, i1 - 1 + band_width + 1);
+        if (block_start >= block_end) continue;
         
-        for (int j = j_start; j < j_end; j++) {
-            if (local_distances[i][j] == std::numeric_limits<double>::infinity()) {
-                continue;
-            }
-            
-            double cost = local_distances[i][j];
-            double min_prev = std::numeric_limits<double>::infinity();
+        computeDistanceBlock(a, i0, i1, b, block_start, block_end, metric,
+                             local_distances.data() + block_start, m);
+        
+        for (int i = i0; i < i1; i++) {
+            const double* local = local_distances.data() + (size_t)(i - i0) * m;
+            int j_start = std::max(0, i - band_width);
+            int j_end = std::min(m, i + band_width + 1);
             
-            // Check three possible previous cells
-            if (i > 0 && j > 0) {
-                min_prev = std::min(min_prev, cost_matrix[i-1][j-1]); // diagonal
-            }
-            if (i > 0) {
-                min_prev = std::min(min_prev, cost_matrix[i-1][j]); // vertical
-            }
-            if (j > 0) {
-                min_prev = std::min(min_prev, cost_matrix[i][j-1]); // horizontal
+            for (int j = j_start; j < j_end; j++) {
+                if (i == 0 && j == 0) {
+                    cost_matrix[0][0] = local[0];
+                    continue;
+                }
+                
+                double min_prev = std::numeric_limits<double>::infinity();
+                
+                // Check three possible previous cells
+                if (i > 0 && j > 0) {
+                    min_prev = std::min(min_prev, cost_matrix[i-1][j-1]); // diagonal
+                }
+                if (i > 0) {
+                    min_prev = std::min(min_prev, cost_matrix[i-1][j]); // vertical
+                }
+                if (j > 0) {
+                    min_prev = std::min(min_prev, cost_matrix[i][j-1]); // horizontal
+                }
+                
+                cost_matrix[i][j] = local[j] + min_prev;
             }
-            
-            cost_matrix[i][j] = cost + min_prev;
         }
     }
     
     DTWResult result;
     result.distance = cost_matrix[n-1][m-1];
+    result.normalized_distance = result.distance / std::max(n, m);
     result.cost_matrix = cost_matrix;
     
     // Backtrack to find optimal path
@@ -181,76 +321,1378 @@ DTWResult computeDTW(const std::vector<std::vector<double>>& sequence1,
     return result;
 }
 
-// Wrapper function for JavaScript interface
-emscripten::val dtw_distance(const emscripten::val& seq1_js, const emscripten::val& seq2_js, int band_width = -1) {
-    // Convert JavaScript arrays to C++ vectors
-    std::vector<std::vector<double>> seq1;
-    std::vector<std::vector<double>> seq2;
+template <class Pattern>
+static DTWResult computeDTWWithWindow(const FeatureMatrix& a, const FeatureMatrix& b,
+                                      WindowType window, double window_param,
+                                      DistanceMetric metric, bool return_path) {
+    switch (window) {
+        case SAKOE_CHIBA:
+            if (window_param > 0) {
+                SakoeChibaWindow sakoe_chiba = {b.rows, static_cast<int>(window_param)};
+                return computeDTWPattern<Pattern>(a, b, sakoe_chiba, metric, return_path);
+            }
+            break;
+        case ITAKURA: {
+            ItakuraWindow itakura = {a.rows, b.rows, window_param > 1.0 ? window_param : 2.0};
+            return computeDTWPattern<Pattern>(a, b, itakura, metric, return_path);
+        }
+        case NO_WINDOW:
+            break;
+    }
+    
+    return computeDTWPattern<Pattern>(a, b, NoWindow{b.rows}, metric, return_path);
+}
+
+// Select the step pattern and window instantiation once per call
+DTWResult computeDTWConstrained(const FeatureMatrix& a,
+                                const FeatureMatrix& b,
+                                StepPatternType pattern,
+                                WindowType window,
+                                double window_param,
+                                DistanceMetric metric,
+                                bool return_path) {
+    switch (pattern) {
+        case SYMMETRIC2:
+            return computeDTWWithWindow<Symmetric2>(a, b, window, window_param, metric, return_path);
+        case ASYMMETRIC:
+            return computeDTWWithWindow<Asymmetric>(a, b, window, window_param, metric, return_path);
+        case SYMMETRIC_P1:
+            return computeDTWWithWindow<SymmetricP1>(a, b, window, window_param, metric, return_path);
+        case RABINER_JUANG_IIID:
+            return computeDTWWithWindow<RabinerJuangIIId>(a, b, window, window_param, metric, return_path);
+        case SYMMETRIC1:
+            break;
+    }
+    
+    return computeDTWWithWindow<Symmetric1>(a, b, window, window_param, metric, return_path);
+}
+
+// Row-by-row DTW with rolling buffers and an early exit against upper_bound
+double computeDTWBounded(const FeatureMatrix& a,
+                         const FeatureMatrix& b,
+                         double upper_bound,
+                         int band_width,
+                         DistanceMetric metric) {
+    DTWWorkspace workspace;
+    return computeDTWBounded(a, b, upper_bound, band_width, metric, workspace);
+}
+
+double computeDTWBounded(const FeatureMatrix& a,
+                         const FeatureMatrix& b,
+                         double upper_bound,
+                         int band_width,
+                         DistanceMetric metric,
+                         DTWWorkspace& workspace) {
+    const double INF = std::numeric_limits<double>::infinity();
+    int n = a.rows;
+    int m = b.rows;
+    
+    if (n == 0 || m == 0) {
+        return INF;
+    }
+    
+    if (band_width <= 0) {
+        band_width = std::max(n, m);
+    }
+    
+    std::vector<double>& local_distances = workspace.local_distances;
+    std::vector<double>& prev_row = workspace.prev_row;
+    std::vector<double>& cur_row = workspace.cur_row;
+    local_distances.resize((size_t)DISTANCE_TILE_ROWS * m);
+    prev_row.assign(m, INF);
+    cur_row.assign(m, INF);
+    
+    for (int i = 0; i < n; i++) {
+        int j_start = std::max(0, i - band_width);
+        int j_end = std::min(m, i + band_width + 1);
+        if (j_start >= j_end) return INF;
+        
+        if (i % DISTANCE_TILE_ROWS == 0) {
+            int i1 = std::min(n, i + DISTANCE_TILE_ROWS);
+            int block_end = std::min(m, i1 - 1 + band_width + 1);
+            computeDistanceBlock(a, i, i1, b, j_start, block_end, metric,
+                                 local_distances.data() + j_start, m);
+        }
+        const double* local = local_distances.data() + (size_t)(i % DISTANCE_TILE_ROWS) * m;
+        
+        // Cells left of the band keep INF from the previous use of this buffer
+        if (j_start > 0) cur_row[j_start - 1] = INF;
+        
+        double row_min = INF;
+        for (int j = j_start; j < j_end; j++) {
+            double min_prev;
+            if (i == 0) {
+                min_prev = (j == 0) ? 0.0 : cur_row[j-1];
+            } else {
+                min_prev = prev_row[j];
+                if (j > 0) {
+                    min_prev = std::min(min_prev, prev_row[j-1]);
+                    min_prev = std::min(min_prev, cur_row[j-1]);
+                }
+            }
+            
+            cur_row[j] = local[j] + min_prev;
+            row_min = std::min(row_min, cur_row[j]);
+        }
+        
+        if (row_min > upper_bound) {
+            return DTW_EXCEEDS_BOUND;
+        }
+        
+        // Clear the cell right of the band so the next row does not read stale costs
+        if (j_end < m) cur_row[j_end] = INF;
+        std::swap(prev_row, cur_row);
+    }
+    
+    double distance = prev_row[m-1];
+    return distance > upper_bound ? DTW_EXCEEDS_BOUND : distance;
+}
+
+QueryEnvelope computeQueryEnvelope(const FeatureMatrix& query, int band_width) {
+    QueryEnvelope envelope;
+    int n = query.rows;
+    envelope.dims = query.dims;
+    if (n == 0 || !query.uniform) return envelope;
+    
+    // Unconstrained DTW: every query row is admissible for every reference frame
+    if (band_width <= 0) {
+        envelope.length = std::numeric_limits<int>::max();
+        envelope.upper.assign(query.dims, -std::numeric_limits<double>::infinity());
+        envelope.lower.assign(query.dims, std::numeric_limits<double>::infinity());
+        for (int i = 0; i < n; i++) {
+            for (int d = 0; d < query.dims; d++) {
+                envelope.upper[d] = std::max(envelope.upper[d], query.row(i)[d]);
+                envelope.lower[d] = std::min(envelope.lower[d], query.row(i)[d]);
+            }
+        }
+        return envelope;
+    }
+    
+    envelope.length = n + band_width;
+    envelope.upper.resize((size_t)envelope.length * query.dims);
+    envelope.lower.resize((size_t)envelope.length * query.dims);
+    
+    // Sliding-window max/min with monotonic deques: O(n * dims)
+    std::vector<int> max_queue(n), min_queue(n);
+    for (int d = 0; d < query.dims; d++) {
+        int max_head = 0, max_tail = 0, min_head = 0, min_tail = 0;
+        int next = 0;
+        
+        for (int c = 0; c < envelope.length; c++) {
+            int hi = std::min(n - 1, c + band_width);
+            for (; next <= hi; next++) {
+                double x = query.row(next)[d];
+                while (max_tail > max_head && query.row(max_queue[max_tail - 1])[d] <= x) max_tail--;
+                max_queue[max_tail++] = next;
+                while (min_tail > min_head && query.row(min_queue[min_tail - 1])[d] >= x) min_tail--;
+                min_queue[min_tail++] = next;
+            }
+            
+            int lo = c - band_width;
+            while (max_queue[max_head] < lo) max_head++;
+            while (min_queue[min_head] < lo) min_head++;
+            
+            envelope.upper[(size_t)c * query.dims + d] = query.row(max_queue[max_head])[d];
+            envelope.lower[(size_t)c * query.dims + d] = query.row(min_queue[min_head])[d];
+        }
+    }
+    
+    return envelope;
+}
+
+double lowerBoundKeogh(const QueryEnvelope& envelope, const FeatureMatrix& reference, double upper_bound) {
+    const double INF = std::numeric_limits<double>::infinity();
+    if (envelope.length == 0 || reference.dims != envelope.dims || !reference.uniform) return INF;
+    
+    bool global = envelope.length == std::numeric_limits<int>::max();
+    double bound = 0.0;
+    
+    for (int j = 0; j < reference.rows; j++) {
+        if (j >= envelope.length) return INF;
+        
+        size_t offset = global ? 0 : (size_t)j * envelope.dims;
+        const double* upper = envelope.upper.data() + offset;
+        const double* lower = envelope.lower.data() + offset;
+        const double* frame = reference.row(j);
+        
+        double sq = 0.0;
+        for (int d = 0; d < envelope.dims; d++) {
+            double excess = frame[d] > upper[d] ? frame[d] - upper[d]
+                          : frame[d] < lower[d] ? lower[d] - frame[d] : 0.0;
+            sq += excess * excess;
+        }
+        bound += sqrt(sq);
+        
+        if (bound > upper_bound) break;
+    }
+    
+    return bound;
+}
+
+std::vector<double> computeDTWBatch(const FeatureMatrix& query,
+                                    const std::vector<const FeatureMatrix*>& references,
+                                    int band_width,
+                                    DistanceMetric metric,
+                                    double max_distance,
+                                    std::vector<std::vector<std::pair<int, int>>>* paths) {
+    std::vector<double> distances(references.size(), DTW_EXCEEDS_BOUND);
+    if (paths) paths->assign(references.size(), {});
+    
+    bool bounded = max_distance != std::numeric_limits<double>::infinity();
+    QueryEnvelope envelope;
+    if (bounded && metric == EUCLIDEAN) {
+        envelope = computeQueryEnvelope(query, band_width);
+    }
+    
+    DTWWorkspace workspace;
+    for (size_t k = 0; k < references.size(); k++) {
+        const FeatureMatrix& reference = *references[k];
+        
+        // Cheap O(m * dims) rejection before any DP work
+        if (envelope.length > 0 && lowerBoundKeogh(envelope, reference, max_distance) > max_distance) {
+            continue;
+        }
+        
+        if (!paths) {
+            distances[k] = computeDTWBounded(query, reference, max_distance, band_width, metric, workspace);
+            continue;
+        }
+        
+        // Paths need the full cost matrix, so there is no early exit here
+        DTWResult result = band_width > 0
+            ? computeDTWPattern<Symmetric1>(query, reference, SakoeChibaWindow{reference.rows, band_width}, metric, true)
+            : computeDTWPattern<Symmetric1>(query, reference, NoWindow{reference.rows}, metric, true);
+        if (result.distance <= max_distance) {
+            distances[k] = result.distance;
+            (*paths)[k] = std::move(result.path);
+        }
+    }
+    
+    return distances;
+}
+
+// Tile edge length for the wavefront DTW. Large enough that a tile's DP work
+// dwarfs the per-diagonal synchronisation, small enough that a 10k x 10k matrix
+// still has ~80 tiles on its longest anti-diagonal to spread across cores.
+const int WAVEFRONT_TILE_SIZE = 128;
+
+// Fill one wavefront tile. Edges between tiles live in three rotating buffers per
+// axis (indexed by tile row/column mod 3): a tile on anti-diagonal d reads edges
+// written on d-1 and d-2, and nobody overwrites them before d+1.
+static void computeWavefrontTile(const FeatureMatrix& a, const FeatureMatrix& b,
+                                 int tile_row, int tile_col, int band_width, DistanceMetric metric,
+                                 std::vector<double> (&bottom_edges)[3],
+                                 std::vector<double> (&right_edges)[3]) {
+    const double INF = std::numeric_limits<double>::infinity();
+    const int n = a.rows;
+    const int m = b.rows;
+    const int i0 = tile_row * WAVEFRONT_TILE_SIZE, i1 = std::min(n, i0 + WAVEFRONT_TILE_SIZE);
+    const int j0 = tile_col * WAVEFRONT_TILE_SIZE, j1 = std::min(m, j0 + WAVEFRONT_TILE_SIZE);
+    const int cols = j1 - j0;
+    
+    double* bottom_out = bottom_edges[tile_row % 3].data();
+    double* right_out = right_edges[tile_col % 3].data();
+    
+    // Tile lies entirely outside the band
+    if (j0 > i1 - 1 + band_width || j1 - 1 < i0 - band_width) {
+        std::fill(bottom_out + j0, bottom_out + j1, INF);
+        std::fill(right_out + i0, right_out + i1, INF);
+        return;
+    }
+    
+    const double* top = tile_row > 0 ? bottom_edges[(tile_row - 1) % 3].data() : nullptr;
+    const double* left = tile_col > 0 ? right_edges[(tile_col - 1) % 3].data() : nullptr;
+    
+    thread_local std::vector<double> local;
+    thread_local std::vector<double> prev_row, cur_row;
+    local.resize((size_t)WAVEFRONT_TILE_SIZE * WAVEFRONT_TILE_SIZE);
+    prev_row.resize(WAVEFRONT_TILE_SIZE + 1);
+    cur_row.resize(WAVEFRONT_TILE_SIZE + 1);
+    
+    computeDistanceBlock(a, i0, i1, b, j0, j1, metric, local.data(), WAVEFRONT_TILE_SIZE);
+    
+    // Rows carry one extra leading cell for column j0 - 1 (the left neighbour)
+    prev_row[0] = (top && left) ? top[j0 - 1] : INF;
+    for (int c = 0; c < cols; c++) {
+        prev_row[c + 1] = top ? top[j0 + c] : INF;
+    }
+    
+    for (int i = i0; i < i1; i++) {
+        const double* local_row = local.data() + (size_t)(i - i0) * WAVEFRONT_TILE_SIZE;
+        int j_start = std::max(j0, i - band_width);
+        int j_end = std::min(j1, i + band_width + 1);
+        
+        cur_row[0] = left ? left[i] : INF;
+        for (int j = j0; j < j1; j++) {
+            int c = j - j0 + 1;
+            if (j < j_start || j >= j_end) {
+                cur_row[c] = INF;
+                continue;
+            }
+            if (i == 0 && j == 0) {
+                cur_row[c] = local_row[0];
+                continue;
+            }
+            
+            // Same operand order as computeDTW, so results are bit-identical
+            double min_prev = INF;
+            min_prev = std::min(min_prev, prev_row[c - 1]); // diagonal
+            min_prev = std::min(min_prev, prev_row[c]);     // vertical
+            min_prev = std::min(min_prev, cur_row[c - 1]);  // horizontal
+            cur_row[c] = local_row[j - j0] + min_prev;
+        }
+        
+        right_out[i] = cur_row[cols];
+        std::swap(prev_row, cur_row);
+    }
+    
+    std::copy(prev_row.begin() + 1, prev_row.begin() + 1 + cols, bottom_out + j0);
+}
+
+// Distance-only DTW over anti-diagonal waves of tiles
+double computeDTWParallel(const FeatureMatrix& a,
+                          const FeatureMatrix& b,
+                          int band_width,
+                          DistanceMetric metric,
+                          ThreadPool& pool) {
+    int n = a.rows;
+    int m = b.rows;
+    
+    if (n == 0 || m == 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    
+    if (band_width <= 0) {
+        band_width = std::max(n, m);
+    }
+    
+    std::vector<double> bottom_edges[3], right_edges[3];
+    for (int k = 0; k < 3; k++) {
+        bottom_edges[k].assign(m, std::numeric_limits<double>::infinity());
+        right_edges[k].assign(n, std::numeric_limits<double>::infinity());
+    }
+    
+    int tile_rows = (n + WAVEFRONT_TILE_SIZE - 1) / WAVEFRONT_TILE_SIZE;
+    int tile_cols = (m + WAVEFRONT_TILE_SIZE - 1) / WAVEFRONT_TILE_SIZE;
+    
+    // Every tile on one anti-diagonal depends only on the previous two
+    for (int diagonal = 0; diagonal < tile_rows + tile_cols - 1; diagonal++) {
+        int first_row = std::max(0, diagonal - tile_cols + 1);
+        int last_row = std::min(tile_rows - 1, diagonal);
+        
+        pool.parallelFor(last_row - first_row + 1, [&](int k) {
+            int tile_row = first_row + k;
+            computeWavefrontTile(a, b, tile_row, diagonal - tile_row, band_width, metric,
+                                 bottom_edges, right_edges);
+        });
+    }
+    
+    return bottom_edges[(tile_rows - 1) % 3][m - 1];
+}
+
+// Sum of DTW distances from every usable sequence to the average
+static double alignToAverage(const FeatureMatrix& average, const std::vector<FeatureMatrix>& sequences,
+                             const std::vector<int>& members, int band_width,
+                             std::vector<double>* sums, std::vector<int>* counts) {
+    double total = 0.0;
+    
+    for (int k : members) {
+        const FeatureMatrix& sequence = sequences[k];
+        if (!sequence.uniform || sequence.dims != average.dims || sequence.rows == 0) continue;
+        
+        DTWResult result = band_width > 0
+            ? computeDTWPattern<Symmetric1>(average, sequence, SakoeChibaWindow{sequence.rows, band_width}, EUCLIDEAN, sums != nullptr)
+            : computeDTWPattern<Symmetric1>(average, sequence, NoWindow{sequence.rows}, EUCLIDEAN, sums != nullptr);
+        total += result.distance;
+        
+        if (sums) {
+            for (const auto& step : result.path) {
+                const double* frame = sequence.row(step.second);
+                double* sum = sums->data() + (size_t)step.first * average.dims;
+                for (int d = 0; d < average.dims; d++) {
+                    sum[d] += frame[d];
+                }
+                (*counts)[step.first]++;
+            }
+        }
+    }
+    
+    return total;
+}
+
+// Member whose summed DTW distance to the other members is smallest
+static int findMedoid(const std::vector<FeatureMatrix>& sequences, const std::vector<int>& members, int band_width) {
+    int medoid = members.empty() ? -1 : members[0];
+    double best = std::numeric_limits<double>::infinity();
+    
+    for (int k : members) {
+        if (!sequences[k].uniform || sequences[k].rows == 0) continue;
+        double total = alignToAverage(sequences[k], sequences, members, band_width, nullptr, nullptr);
+        if (total < best) {
+            best = total;
+            medoid = k;
+        }
+    }
+    
+    return medoid;
+}
+
+static FeatureMatrix averageMembers(const std::vector<FeatureMatrix>& sequences, const std::vector<int>& members,
+                                    int max_iterations, int band_width) {
+    int medoid = findMedoid(sequences, members, band_width);
+    if (medoid < 0) return FeatureMatrix();
+    
+    FeatureMatrix average = sequences[medoid];
+    double inertia = alignToAverage(average, sequences, members, band_width, nullptr, nullptr);
+    
+    std::vector<double> sums;
+    std::vector<int> counts;
+    for (int iteration = 0; iteration < max_iterations; iteration++) {
+        sums.assign(average.data.size(), 0.0);
+        counts.assign(average.rows, 0);
+        alignToAverage(average, sequences, members, band_width, &sums, &counts);
+        
+        FeatureMatrix candidate = average;
+        for (int i = 0; i < candidate.rows; i++) {
+            if (counts[i] == 0) continue;
+            double* frame = candidate.row(i);
+            for (int d = 0; d < candidate.dims; d++) {
+                frame[d] = sums[(size_t)i * candidate.dims + d] / counts[i];
+            }
+        }
+        candidate.updateNorms();
+        
+        // DBA is not guaranteed to descend on every step; keep the best average
+        double candidate_inertia = alignToAverage(candidate, sequences, members, band_width, nullptr, nullptr);
+        if (!(candidate_inertia < inertia)) break;
+        
+        bool converged = inertia - candidate_inertia <= 1e-6 * inertia;
+        average = std::move(candidate);
+        inertia = candidate_inertia;
+        if (converged) break;
+    }
+    
+    return average;
+}
+
+FeatureMatrix computeDBA(const std::vector<FeatureMatrix>& sequences, int max_iterations, int band_width) {
+    std::vector<int> members(sequences.size());
+    for (size_t k = 0; k < sequences.size(); k++) members[k] = k;
+    return averageMembers(sequences, members, max_iterations, band_width);
+}
+
+std::vector<FeatureMatrix> buildReferenceTemplates(const std::vector<FeatureMatrix>& sequences,
+                                                   int num_templates,
+                                                   int max_iterations,
+                                                   int band_width) {
+    if (sequences.empty()) return {};
+    if (num_templates <= 1 || sequences.size() < 2) {
+        return {computeDBA(sequences, max_iterations, band_width)};
+    }
+    
+    // Seed the second group with the sequence farthest from the medoid, then
+    // assign every sequence to the nearer seed
+    std::vector<int> all(sequences.size());
+    for (size_t k = 0; k < sequences.size(); k++) all[k] = k;
+    int medoid = findMedoid(sequences, all, band_width);
+    
+    int farthest = -1;
+    double farthest_distance = -1.0;
+    std::vector<double> to_medoid(sequences.size());
+    for (int k : all) {
+        to_medoid[k] = alignToAverage(sequences[medoid], sequences, {k}, band_width, nullptr, nullptr);
+        if (k != medoid && to_medoid[k] > farthest_distance) {
+            farthest_distance = to_medoid[k];
+            farthest = k;
+        }
+    }
+    
+    std::vector<int> groups[2];
+    for (int k : all) {
+        double to_farthest = alignToAverage(sequences[farthest], sequences, {k}, band_width, nullptr, nullptr);
+        groups[to_farthest < to_medoid[k] ? 1 : 0].push_back(k);
+    }
+    
+    std::vector<FeatureMatrix> templates;
+    for (const auto& group : groups) {
+        if (!group.empty()) {
+            templates.push_back(averageMembers(sequences, group, max_iterations, band_width));
+        }
+    }
+    
+    return templates;
+}
+
+std::vector<WordSegment> segmentWords(const FeatureMatrix& query,
+                                      const FeatureMatrix& reference,
+                                      const std::vector<std::pair<int, int>>& path,
+                                      const std::vector<int>& word_boundaries,
+                                      DistanceMetric metric) {
+    const int num_words = (int)word_boundaries.size() - 1;
+    if (num_words <= 0 || word_boundaries[0] < 0 || word_boundaries[num_words] > reference.rows) {
+        return {};
+    }
+    for (int w = 0; w < num_words; w++) {
+        if (word_boundaries[w] > word_boundaries[w + 1]) return {};
+    }
+    
+    std::vector<WordSegment> segments(num_words, WordSegment{-1, -1, 0.0, 0.0});
+    std::vector<double> cost_sums(num_words, 0.0);
+    std::vector<int> step_counts(num_words, 0);
+    thread_local std::vector<double> local;
     
-    int len1 = seq1_js["length"].as<int>();
-    for (int i = 0; i < len1; i++) {
-        auto frame = emscripten::vecFromJSArray<double>(seq1_js[i]);
-        seq1.push_back(frame);
+    // The path is monotone, so each query frame covers one contiguous run of
+    // reference frames and the current word only ever moves forward
+    int w = 0;
+    for (size_t k = 0; k < path.size();) {
+        const int i = path[k].first;
+        size_t run_end = k;
+        while (run_end + 1 < path.size() && path[run_end + 1].first == i) run_end++;
+        
+        const int j_lo = path[k].second;
+        const int j_hi = path[run_end].second;
+        local.resize(j_hi - j_lo + 1);
+        computeDistanceBlock(query, i, i + 1, reference, j_lo, j_hi + 1, metric, local.data(), j_hi - j_lo + 1);
+        
+        for (size_t s = k; s <= run_end; s++) {
+            const int j = path[s].second;
+            while (w + 1 < num_words && j >= word_boundaries[w + 1]) w++;
+            if (j < word_boundaries[w] || j >= word_boundaries[w + 1]) continue;
+            
+            WordSegment& segment = segments[w];
+            if (segment.start < 0) segment.start = i;
+            segment.end = i;
+            cost_sums[w] += local[j - j_lo];
+            step_counts[w]++;
+        }
+        k = run_end + 1;
     }
     
-    int len2 = seq2_js["length"].as<int>();
-    for (int i = 0; i < len2; i++) {
-        auto frame = emscripten::vecFromJSArray<double>(seq2_js[i]);
-        seq2.push_back(frame);
+    for (int v = 0; v < num_words; v++) {
+        WordSegment& segment = segments[v];
+        if (segment.start < 0) continue;
+        const int reference_frames = word_boundaries[v + 1] - word_boundaries[v];
+        segment.average_cost = cost_sums[v] / step_counts[v];
+        segment.duration_ratio = static_cast<double>(segment.end - segment.start + 1) / reference_frames;
     }
     
+    return segments;
+}
+
+// Subsequence DTW with free start and end on the series axis
+std::vector<SubsequenceMatch> computeSubsequenceDTW(const std::vector<std::vector<double>>& query,
+                                                    const std::vector<std::vector<double>>& series,
+                                                    int num_matches,
+                                                    DistanceMetric metric) {
+    const double INF = std::numeric_limits<double>::infinity();
+    int m = query.size();
+    int n = series.size();
+    
+    if (m == 0 || n == 0 || num_matches <= 0) {
+        return {};
+    }
+    
+    FeatureMatrix q_frames = toFeatureMatrix(query);
+    FeatureMatrix s_frames = toFeatureMatrix(series);
+    std::vector<double> local_distances((size_t)DISTANCE_TILE_ROWS * m);
+    
+    // Rolling columns over the query axis: O(m) working memory. Each cell also
+    // carries the series frame its path started on, so no backtracking is needed.
+    std::vector<double> prev_cost(m, INF), cur_cost(m, INF);
+    std::vector<int> prev_start(m, 0), cur_start(m, 0);
+    
+    // Single best match is tracked online; k-best needs the cost of every end frame
+    SubsequenceMatch best = {-1, -1, INF};
+    std::vector<double> end_cost;
+    std::vector<int> end_start;
+    if (num_matches > 1) {
+        end_cost.resize(n);
+        end_start.resize(n);
+    }
+    
+    for (int t = 0; t < n; t++) {
+        if (t % DISTANCE_TILE_ROWS == 0) {
+            computeDistanceBlock(s_frames, t, std::min(n, t + DISTANCE_TILE_ROWS), q_frames, 0, m,
+                                 metric, local_distances.data(), m);
+        }
+        const double* local = local_distances.data() + (size_t)(t % DISTANCE_TILE_ROWS) * m;
+        
+        // Free start: the first query frame may begin on any series frame
+        cur_cost[0] = local[0];
+        cur_start[0] = t;
+        
+        for (int q = 1; q < m; q++) {
+            double min_prev = INF;
+            int start = t;
+            
+            if (t > 0 && prev_cost[q-1] < min_prev) { // diagonal
+                min_prev = prev_cost[q-1];
+                start = prev_start[q-1];
+            }
+            if (cur_cost[q-1] < min_prev) { // next query frame, same series frame
+                min_prev = cur_cost[q-1];
+                start = cur_start[q-1];
+            }
+            if (t > 0 && prev_cost[q] < min_prev) { // same query frame, next series frame
+                min_prev = prev_cost[q];
+                start = prev_start[q];
+            }
+            
+            cur_cost[q] = min_prev + local[q];
+            cur_start[q] = start;
+        }
+        
+        // Free end: every series frame is a candidate end of the match
+        if (num_matches > 1) {
+            end_cost[t] = cur_cost[m-1];
+            end_start[t] = cur_start[m-1];
+        } else if (cur_cost[m-1] < best.distance) {
+            best = {cur_start[m-1], t, cur_cost[m-1]};
+        }
+        
+        std::swap(prev_cost, cur_cost);
+        std::swap(prev_start, cur_start);
+    }
+    
+    if (num_matches == 1) {
+        if (best.distance == INF) return {};
+        return {best};
+    }
+    
+    // k-best: take end frames in order of increasing cost and keep each one
+    // whose span does not overlap a match that was already accepted
+    std::vector<int> order(n);
+    for (int t = 0; t < n; t++) order[t] = t;
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return end_cost[a] < end_cost[b] || (end_cost[a] == end_cost[b] && a < b);
+    });
+    
+    std::vector<SubsequenceMatch> matches;
+    for (int t : order) {
+        if ((int)matches.size() >= num_matches || end_cost[t] == INF) break;
+        
+        bool overlaps = false;
+        for (const auto& match : matches) {
+            if (end_start[t] <= match.end && t >= match.start) {
+                overlaps = true;
+                break;
+            }
+        }
+        if (!overlaps) {
+            matches.push_back({end_start[t], t, end_cost[t]});
+        }
+    }
+    
+    return matches;
+}
+
+// Online time warping over a moving window of reference frames
+OnlineDTW::OnlineDTW(const std::vector<std::vector<double>>& reference_frames, int window_size, DistanceMetric metric)
+    : reference(toFeatureMatrix(reference_frames)), metric(metric) {
+    int m = reference.rows;
+    window = (window_size <= 0 || window_size > m) ? m : window_size;
+    prev_row.resize(window);
+    cur_row.resize(window);
+    local_row.resize(window);
+    frame_buffer.rows = 1;
+    reset();
+}
+
+void OnlineDTW::reset() {
+    std::fill(prev_row.begin(), prev_row.end(), std::numeric_limits<double>::infinity());
+    prev_start = 0;
+    frames = 0;
+    current_position = 0;
+    current_cost = std::numeric_limits<double>::infinity();
+}
+
+// Consume one user frame and return the reference frame it is aligned to
+int OnlineDTW::pushFrame(const std::vector<double>& frame) {
+    const double INF = std::numeric_limits<double>::infinity();
+    int m = reference.rows;
+    if (m == 0) return -1;
+    
+    // A frame of the wrong dimension is rejected without touching the state, so
+    // tracking continues with the next valid frame
+    if ((int)frame.size() != reference.dims) return -1;
+    
+    frame_buffer.dims = frame.size();
+    frame_buffer.data = frame;
+    frame_buffer.updateNorms();
+    
+    // Centre the window on the last position. It only moves forward, and by
+    // at most half its width per frame, so it always overlaps the previous row.
+    int start = 0;
+    if (frames > 0) {
+        start = std::max(prev_start, current_position - window / 2);
+        start = std::min(start, m - window);
+    }
+    
+    computeDistanceBlock(frame_buffer, 0, 1, reference, start, start + window, metric, local_row.data(), window);
+    
+    int best = -1;
+    double best_score = INF;
+    
+    for (int k = 0; k < window; k++) {
+        int j = start + k;
+        double min_prev;
+        
+        if (frames == 0) {
+            // First user frame: the path starts at reference frame 0
+            min_prev = (k == 0) ? 0.0 : cur_row[k-1];
+        } else {
+            int p = j - prev_start; // index of (t-1, j) in prev_row
+            min_prev = INF;
+            if (p - 1 >= 0 && p - 1 < window) {
+                min_prev = std::min(min_prev, prev_row[p-1]); // diagonal
+            }
+            if (p >= 0 && p < window) {
+                min_prev = std::min(min_prev, prev_row[p]);   // vertical
+            }
+            if (k > 0) {
+                min_prev = std::min(min_prev, cur_row[k-1]);  // horizontal
+            }
+        }
+        
+        cur_row[k] = min_prev + local_row[k];
+        
+        // Compare cells by cost per step so later reference frames are not
+        // penalised just for having longer paths
+        double score = cur_row[k] / (frames + j + 2);
+        if (score < best_score) {
+            best_score = score;
+            best = j;
+        }
+    }
+    
+    std::swap(prev_row, cur_row);
+    prev_start = start;
+    frames++;
+    
+    if (best >= 0) {
+        current_position = best;
+        current_cost = prev_row[best - start];
+    }
+    return current_position;
+}
+
+DTWSession::DTWSession(const FeatureMatrix& reference_frames, int band_width, DistanceMetric metric)
+    : reference(reference_frames), band(band_width), metric(metric) {
+    query.dims = reference.dims;
+}
+
+double DTWSession::replaceSuffix(int keep_rows, const FeatureMatrix& frames) {
+    const double INF = std::numeric_limits<double>::infinity();
+    const int m = reference.rows;
+    const int dims = query.dims;
+    if (frames.rows > 0 && (!frames.uniform || frames.dims != dims)) {
+        return INF;
+    }
+    
+    // Splice the query and extend its norms for the new frames only
+    const int keep = std::max(0, std::min(keep_rows, query.rows));
+    const int n = keep + frames.rows;
+    query.rows = n;
+    query.data.resize((size_t)keep * dims);
+    query.data.insert(query.data.end(), frames.data.begin(), frames.data.begin() + (size_t)frames.rows * dims);
+    query.sq_norms.resize(n);
+    query.norms.resize(n);
+    for (int i = keep; i < n; i++) {
+        const double* frame = query.row(i);
+        double sq = 0.0;
+        for (int d = 0; d < dims; d++) sq += frame[d] * frame[d];
+        query.sq_norms[i] = sq;
+        query.norms[i] = sqrt(sq);
+    }
+    
+    cost.resize((size_t)n * m);
+    if (m == 0) return distance();
+    
+    const int reach = band > 0 ? band : std::max(n, m);
+    local_distances.resize((size_t)DISTANCE_TILE_ROWS * m);
+    
+    // Rows [0, keep) are still valid; recompute the rest in blocks like computeDTW
+    for (int i0 = keep; i0 < n; i0 += DISTANCE_TILE_ROWS) {
+        int i1 = std::min(n, i0 + DISTANCE_TILE_ROWS);
+        int block_start = std::max(0, i0 - reach);
+        int block_end = std::min(m, i1 - 1 + reach + 1);
+        if (block_start < block_end) {
+            computeDistanceBlock(query, i0, i1, reference, block_start, block_end, metric,
+                                 local_distances.data() + block_start, m);
+        }
+        
+        for (int i = i0; i < i1; i++) {
+            const double* local = local_distances.data() + (size_t)(i - i0) * m;
+            double* row = cost.data() + (size_t)i * m;
+            const double* prev = i > 0 ? row - m : nullptr;
+            int j_start = std::max(0, i - reach);
+            int j_end = std::min(m, i + reach + 1);
+            std::fill(row, row + m, INF);
+            
+            for (int j = j_start; j < j_end; j++) {
+                if (i == 0 && j == 0) {
+                    row[0] = local[0];
+                    continue;
+                }
+                
+                double min_prev = INF;
+                if (i > 0 && j > 0) min_prev = std::min(min_prev, prev[j-1]);
+                if (i > 0) min_prev = std::min(min_prev, prev[j]);
+                if (j > 0) min_prev = std::min(min_prev, row[j-1]);
+                row[j] = local[j] + min_prev;
+            }
+        }
+    }
+    
+    return distance();
+}
+
+double DTWSession::distance() const {
+    if (query.rows == 0 || reference.rows == 0) return std::numeric_limits<double>::infinity();
+    return cost[(size_t)query.rows * reference.rows - 1];
+}
+
+double DTWSession::normalizedDistance() const {
+    return distance() / std::max(query.rows, reference.rows);
+}
+
+// Same backtrack and tie-breaking as computeDTW
+std::vector<std::pair<int, int>> DTWSession::path() const {
+    std::vector<std::pair<int, int>> steps;
+    if (distance() == std::numeric_limits<double>::infinity()) return steps;
+    
+    const int m = reference.rows;
+    auto at = [&](int i, int j) { return cost[(size_t)i * m + j]; };
+    int i = query.rows - 1;
+    int j = m - 1;
+    while (i > 0 || j > 0) {
+        steps.push_back({i, j});
+        if (i == 0) {
+            j--;
+        } else if (j == 0) {
+            i--;
+        } else {
+            double diag = at(i-1, j-1);
+            double up = at(i-1, j);
+            double left = at(i, j-1);
+            if (diag <= up && diag <= left) {
+                i--; j--;
+            } else if (up <= left) {
+                i--;
+            } else {
+                j--;
+            }
+        }
+    }
+    steps.push_back({0, 0});
+    
+    std::reverse(steps.begin(), steps.end());
+    return steps;
+}
+
+#ifdef __EMSCRIPTEN__
+
+// Convert a JavaScript array of frames into a C++ feature sequence
+std::vector<std::vector<double>> sequenceFromJS(const emscripten::val& seq_js) {
+    std::vector<std::vector<double>> seq;
+    int len = seq_js["length"].as<int>();
+    seq.reserve(len);
+    for (int i = 0; i < len; i++) {
+        seq.push_back(emscripten::vecFromJSArray<double>(seq_js[i]));
+    }
+    return seq;
+}
+
+// Copy a C++ buffer into a new JavaScript typed array of the given type
+template <typename T>
+emscripten::val typedArrayCopy(const char* type, const std::vector<T>& values) {
+    return emscripten::val::global(type).new_(emscripten::typed_memory_view(values.size(), values.data()));
+}
+
+// Warping path as one Int32Array of interleaved (i, j) pairs. Built in a C++
+// buffer and copied across once, instead of one JS array per step.
+emscripten::val pathToJS(const std::vector<std::pair<int, int>>& path) {
+    std::vector<int32_t> interleaved(path.size() * 2);
+    for (size_t k = 0; k < path.size(); k++) {
+        interleaved[2 * k] = path[k].first;
+        interleaved[2 * k + 1] = path[k].second;
+    }
+    return typedArrayCopy("Int32Array", interleaved);
+}
+
+// Wrapper function for JavaScript interface
+emscripten::val dtw_distance(const emscripten::val& seq1_js, const emscripten::val& seq2_js, int band_width = -1) {
+    // Convert JavaScript arrays to C++ vectors
+    auto seq1 = sequenceFromJS(seq1_js);
+    auto seq2 = sequenceFromJS(seq2_js);
+    
     // Compute DTW
     auto result = computeDTW(seq1, seq2, band_width, EUCLIDEAN, false);
     
     // Return result as JavaScript object
     emscripten::val js_result = emscripten::val::object();
     js_result.set("distance", result.distance);
-    js_result.set("normalized_distance", result.distance / std::max(seq1.size(), seq2.size()));
+    js_result.set("normalized_distance", result.normalized_distance);
     
     return js_result;
 }
 
 // Advanced DTW with path tracking
 emscripten::val dtw_align(const emscripten::val& seq1_js, const emscripten::val& seq2_js, int band_width = -1) {
-    std::vector<std::vector<double>> seq1;
-    std::vector<std::vector<double>> seq2;
+    auto seq1 = sequenceFromJS(seq1_js);
+    auto seq2 = sequenceFromJS(seq2_js);
     
-    int len1 = seq1_js["length"].as<int>();
-    for (int i = 0; i < len1; i++) {
-        auto frame = emscripten::vecFromJSArray<double>(seq1_js[i]);
-        seq1.push_back(frame);
+    auto result = computeDTW(seq1, seq2, band_width, EUCLIDEAN, true);
+    
+    emscripten::val js_result = emscripten::val::object();
+    js_result.set("distance", result.distance);
+    js_result.set("normalized_distance", result.normalized_distance);
+    js_result.set("path", pathToJS(result.path));
+    
+    return js_result;
+}
+
+// Alignment with a selectable step pattern (StepPatternType) and global
+// constraint (WindowType); normalized_distance uses the pattern's path weight
+emscripten::val dtw_align_pattern(const emscripten::val& seq1_js, const emscripten::val& seq2_js,
+                                  int step_pattern, int window_type, double window_param) {
+    FeatureMatrix a = toFeatureMatrix(sequenceFromJS(seq1_js));
+    FeatureMatrix b = toFeatureMatrix(sequenceFromJS(seq2_js));
+    auto result = computeDTWConstrained(a, b, static_cast<StepPatternType>(step_pattern),
+                                        static_cast<WindowType>(window_type), window_param, EUCLIDEAN, true);
+    
+    emscripten::val js_result = emscripten::val::object();
+    js_result.set("distance", result.distance);
+    js_result.set("normalized_distance", result.normalized_distance);
+    js_result.set("path", pathToJS(result.path));
+    
+    return js_result;
+}
+
+// Convert a FeatureMatrix back into a JavaScript array of frames
+emscripten::val sequenceToJS(const FeatureMatrix& matrix) {
+    emscripten::val frames = emscripten::val::array();
+    for (int i = 0; i < matrix.rows; i++) {
+        frames.set(i, emscripten::val::array(matrix.row(i), matrix.row(i) + matrix.dims));
     }
+    return frames;
+}
+
+// Average several reference recitations into one or two DBA templates
+emscripten::val dtw_barycenter(const emscripten::val& sequences_js, int num_templates, int max_iterations, int band_width) {
+    std::vector<FeatureMatrix> sequences;
+    int count = sequences_js["length"].as<int>();
+    for (int k = 0; k < count; k++) {
+        sequences.push_back(toFeatureMatrix(sequenceFromJS(sequences_js[k])));
+    }
+    
+    auto templates = buildReferenceTemplates(sequences, num_templates, max_iterations, band_width);
     
-    int len2 = seq2_js["length"].as<int>();
-    for (int i = 0; i < len2; i++) {
-        auto frame = emscripten::vecFromJSArray<double>(seq2_js[i]);
-        seq2.push_back(frame);
+    emscripten::val js_templates = emscripten::val::array();
+    for (size_t k = 0; k < templates.size(); k++) {
+        js_templates.set(k, sequenceToJS(templates[k]));
     }
+    return js_templates;
+}
+
+// Pass/fail check: is the alignment distance within max_distance?
+emscripten::val dtw_within_bound(const emscripten::val& seq1_js, const emscripten::val& seq2_js, int band_width, double max_distance) {
+    FeatureMatrix a = toFeatureMatrix(sequenceFromJS(seq1_js));
+    FeatureMatrix b = toFeatureMatrix(sequenceFromJS(seq2_js));
+    double distance = computeDTWBounded(a, b, max_distance, band_width, EUCLIDEAN);
     
-    auto result = computeDTW(seq1, seq2, band_width, EUCLIDEAN, true);
+    emscripten::val js_result = emscripten::val::object();
+    js_result.set("within_bound", distance != DTW_EXCEEDS_BOUND);
+    js_result.set("distance", distance);
+    js_result.set("normalized_distance", distance / std::max(a.rows, b.rows));
+    
+    return js_result;
+}
+
+// Distance-only DTW on all available threads, for long offline alignments
+emscripten::val dtw_distance_parallel(const emscripten::val& seq1_js, const emscripten::val& seq2_js, int band_width) {
+    static ThreadPool pool;
+    
+    FeatureMatrix a = toFeatureMatrix(sequenceFromJS(seq1_js));
+    FeatureMatrix b = toFeatureMatrix(sequenceFromJS(seq2_js));
+    double distance = computeDTWParallel(a, b, band_width, EUCLIDEAN, pool);
+    
+    emscripten::val js_result = emscripten::val::object();
+    js_result.set("distance", distance);
+    js_result.set("normalized_distance", distance / std::max(a.rows, b.rows));
+    
+    return js_result;
+}
+
+// Locate up to num_matches non-overlapping occurrences of query inside series
+emscripten::val dtw_subsequence(const emscripten::val& query_js, const emscripten::val& series_js, int num_matches) {
+    auto query = sequenceFromJS(query_js);
+    auto series = sequenceFromJS(series_js);
+    
+    auto matches = computeSubsequenceDTW(query, series, num_matches, EUCLIDEAN);
+    
+    emscripten::val js_matches = emscripten::val::array();
+    for (size_t k = 0; k < matches.size(); k++) {
+        int span = matches[k].end - matches[k].start + 1;
+        
+        emscripten::val match = emscripten::val::object();
+        match.set("start", matches[k].start);
+        match.set("end", matches[k].end);
+        match.set("distance", matches[k].distance);
+        match.set("normalized_distance", matches[k].distance / std::max<int>(span, query.size()));
+        js_matches.set(k, match);
+    }
+    
+    return js_matches;
+}
+
+// JavaScript interface for OnlineDTW
+OnlineDTW* createOnlineDTW(const emscripten::val& reference_js, int window_size) {
+    return new OnlineDTW(sequenceFromJS(reference_js), window_size, EUCLIDEAN);
+}
+
+int onlineDTWPushFrame(OnlineDTW& aligner, const emscripten::val& frame_js) {
+    return aligner.pushFrame(emscripten::vecFromJSArray<double>(frame_js));
+}
+
+// Sequences uploaded once and referred to by integer handle, so repeated
+// alignments do not re-marshal frames from JavaScript. Each handle can select a
+// preprocessing mode; the preprocessed frames are computed on first use and kept
+// with the handle, so one query is normalized once for any number of references.
+struct SequenceHandle {
+    FeatureMatrix frames;                                           // as uploaded
+    int mode = PREPROCESS_NONE;
+    std::unique_ptr<FeatureMatrix> preprocessed[PREPROCESS_MODES];  // by mode, filled on demand
+
+    const FeatureMatrix* active() const {
+        return mode == PREPROCESS_NONE ? &frames : preprocessed[mode].get();
+    }
+};
+
+static std::vector<std::unique_ptr<SequenceHandle>> sequence_handles;
+
+static int registerSequence(FeatureMatrix matrix) {
+    std::unique_ptr<SequenceHandle> entry(new SequenceHandle());
+    entry->frames = std::move(matrix);
+    for (size_t h = 0; h < sequence_handles.size(); h++) {
+        if (!sequence_handles[h]) {
+            sequence_handles[h] = std::move(entry);
+            return h;
+        }
+    }
+    sequence_handles.push_back(std::move(entry));
+    return sequence_handles.size() - 1;
+}
+
+static SequenceHandle* lookupHandle(int handle) {
+    if (handle < 0 || handle >= (int)sequence_handles.size()) return nullptr;
+    return sequence_handles[handle].get();
+}
+
+// Frames of a handle in its selected preprocessing mode
+static const FeatureMatrix* lookupSequence(int handle) {
+    const SequenceHandle* entry = lookupHandle(handle);
+    return entry ? entry->active() : nullptr;
+}
+
+// Upload a sequence given as an array of frames; returns its handle
+int dtw_upload_sequence(const emscripten::val& seq_js) {
+    return registerSequence(toFeatureMatrix(sequenceFromJS(seq_js)));
+}
+
+// Upload a sequence given as one flat typed array (frames x dims, row-major)
+int dtw_upload_flat(const emscripten::val& data_js, int frames, int dims) {
+    FeatureMatrix matrix;
+    matrix.data = emscripten::convertJSArrayToNumberVector<double>(data_js);
+    if (frames < 0 || dims < 0 || matrix.data.size() != (size_t)frames * dims) {
+        return -1;
+    }
+    matrix.rows = frames;
+    matrix.dims = dims;
+    matrix.updateNorms();
+    return registerSequence(std::move(matrix));
+}
+
+void dtw_release_sequence(int handle) {
+    if (lookupHandle(handle)) {
+        sequence_handles[handle].reset();
+    }
+}
+
+// Select the preprocessing (FeaturePreprocessing flags) used whenever the handle
+// is aligned. Returns false for an unknown handle or mode.
+bool dtw_set_preprocessing(int handle, int mode) {
+    SequenceHandle* entry = lookupHandle(handle);
+    if (!entry || mode < 0 || mode >= PREPROCESS_MODES) {
+        return false;
+    }
+    if (mode != PREPROCESS_NONE && !entry->preprocessed[mode]) {
+        entry->preprocessed[mode].reset(new FeatureMatrix(preprocessFeatures(entry->frames, mode)));
+    }
+    entry->mode = mode;
+    return true;
+}
+
+// Incremental alignment session against an uploaded reference; an unknown
+// handle gives an empty reference and every distance is Infinity. Sessions use
+// the reference as uploaded: z-normalization and slopes depend on the whole
+// query, so they cannot be updated one replaced suffix at a time.
+DTWSession* createDTWSession(int reference_handle, int band_width) {
+    const SequenceHandle* reference = lookupHandle(reference_handle);
+    return new DTWSession(reference ? reference->frames : FeatureMatrix(), band_width, EUCLIDEAN);
+}
+
+// frames_js: the new suffix as one flat Float64Array (frames x dims)
+double dtwSessionReplaceSuffix(DTWSession& session, int keep_rows, const emscripten::val& frames_js, int frames) {
+    FeatureMatrix suffix;
+    suffix.data = emscripten::convertJSArrayToNumberVector<double>(frames_js);
+    if (frames < 0 || (frames > 0 && suffix.data.size() % frames != 0)) {
+        return DTW_EXCEEDS_BOUND;
+    }
+    suffix.rows = frames;
+    suffix.dims = frames > 0 ? suffix.data.size() / frames : 0;
+    suffix.updateNorms();
+    return session.replaceSuffix(keep_rows, suffix);
+}
+
+emscripten::val dtwSessionPath(const DTWSession& session) {
+    return pathToJS(session.path());
+}
+
+// Align one uploaded query against a list of uploaded references. Returns
+// { distances: Float64Array, paths?: Int32Array[] (interleaved i, j) }. Unknown
+// handles and references beyond max_distance get Infinity.
+emscripten::val dtw_batch(int query_handle, const emscripten::val& reference_handles_js,
+                          int band_width, double max_distance, bool return_paths) {
+    std::vector<int> reference_handles = emscripten::convertJSArrayToNumberVector<int>(reference_handles_js);
+    const FeatureMatrix* query = lookupSequence(query_handle);
+    
+    // Only valid handles are aligned; batch_index maps each request slot to them
+    std::vector<const FeatureMatrix*> references;
+    std::vector<int> batch_index(reference_handles.size(), -1);
+    for (size_t k = 0; k < reference_handles.size(); k++) {
+        if (const FeatureMatrix* reference = lookupSequence(reference_handles[k])) {
+            batch_index[k] = references.size();
+            references.push_back(reference);
+        }
+    }
+    
+    std::vector<double> distances(reference_handles.size(), DTW_EXCEEDS_BOUND);
+    std::vector<std::vector<std::pair<int, int>>> paths;
+    if (query) {
+        auto found = computeDTWBatch(*query, references, band_width, EUCLIDEAN, max_distance,
+                                     return_paths ? &paths : nullptr);
+        for (size_t k = 0; k < reference_handles.size(); k++) {
+            if (batch_index[k] >= 0) distances[k] = found[batch_index[k]];
+        }
+    }
+    
+    emscripten::val js_result = emscripten::val::object();
+    js_result.set("distances", typedArrayCopy("Float64Array", distances));
+    
+    if (return_paths) {
+        emscripten::val js_paths = emscripten::val::array();
+        const std::vector<std::pair<int, int>> no_path;
+        for (size_t k = 0; k < reference_handles.size(); k++) {
+            bool aligned = query && batch_index[k] >= 0;
+            js_paths.set(k, pathToJS(aligned ? paths[batch_index[k]] : no_path));
+        }
+        js_result.set("paths", js_paths);
+    }
+    
+    return js_result;
+}
+
+// Align an uploaded query against an uploaded reference and score it word by
+// word. word_boundaries_js is the reference's word starts plus its length
+// (feature_store_word_boundaries). Returns { distance, normalized_distance,
+// words: [{ start, end, average_cost, duration_ratio }] }.
+emscripten::val dtw_align_words(int query_handle, int reference_handle,
+                                const emscripten::val& word_boundaries_js, int band_width) {
+    const FeatureMatrix* query = lookupSequence(query_handle);
+    const FeatureMatrix* reference = lookupSequence(reference_handle);
+    std::vector<int> word_boundaries = emscripten::convertJSArrayToNumberVector<int>(word_boundaries_js);
+    
+    DTWResult result;
+    result.distance = DTW_EXCEEDS_BOUND;
+    result.normalized_distance = DTW_EXCEEDS_BOUND;
+    std::vector<WordSegment> segments;
+    if (query && reference) {
+        result = computeDTWConstrained(*query, *reference, SYMMETRIC1,
+                                       band_width > 0 ? SAKOE_CHIBA : NO_WINDOW, band_width, EUCLIDEAN, true);
+        segments = segmentWords(*query, *reference, result.path, word_boundaries);
+    }
     
     emscripten::val js_result = emscripten::val::object();
     js_result.set("distance", result.distance);
-    js_result.set("normalized_distance", result.distance / std::max(seq1.size(), seq2.size()));
+    js_result.set("normalized_distance", result.normalized_distance);
     
-    // Convert path to JavaScript array
-    emscripten::val path_array = emscripten::val::array();
-    for (size_t i = 0; i < result.path.size(); i++) {
-        emscripten::val point = emscripten::val::array();
-        point.set(0, result.path[i].first);
-        point.set(1, result.path[i].second);
-        path_array.set(i, point);
+    emscripten::val js_words = emscripten::val::array();
+    for (size_t w = 0; w < segments.size(); w++) {
+        emscripten::val word = emscripten::val::object();
+        word.set("start", segments[w].start);
+        word.set("end", segments[w].end);
+        word.set("average_cost", segments[w].average_cost);
+        word.set("duration_ratio", segments[w].duration_ratio);
+        js_words.set(w, word);
     }
-    js_result.set("path", path_array);
+    js_result.set("words", js_words);
     
     return js_result;
 }
 
+// Reference feature store. JavaScript fetches the store file once, copies it
+// into the staging buffer returned by feature_store_buffer() and opens it.
+static FeatureStore reference_store;
+static std::vector<uint8_t> reference_store_staging;
+
+// View over a staging buffer of `size` bytes for JavaScript to fill. The view
+// is invalidated by memory growth, so it must be filled immediately.
+emscripten::val feature_store_buffer(int size) {
+    reference_store.close();
+    reference_store_staging.assign(size > 0 ? size : 0, 0);
+    return emscripten::val(emscripten::typed_memory_view(reference_store_staging.size(), reference_store_staging.data()));
+}
+
+// Open the staged bytes; returns an error message, or an empty string on success
+std::string feature_store_open() {
+    std::string error;
+    if (!reference_store.open(std::move(reference_store_staging), &error)) {
+        return error;
+    }
+    reference_store_staging = std::vector<uint8_t>();
+    return "";
+}
+
+// Align an uploaded query against many verses of the reference store, given as
+// interleaved (surah, ayah) pairs. int8 stores are searched on their stored
+// codes with the quantized kernel, without decoding the reference frames.
+// If the query has a preprocessing mode, every verse is decoded and preprocessed
+// the same way and aligned in double precision.
+// Returns a Float64Array; missing verses and verses beyond max_distance get Infinity.
+emscripten::val feature_store_batch(int query_handle, const emscripten::val& verses_js,
+                                    int band_width, double max_distance) {
+    std::vector<int> keys = emscripten::convertJSArrayToNumberVector<int>(verses_js);
+    const SequenceHandle* entry = lookupHandle(query_handle);
+    const FeatureMatrix* query = entry ? entry->active() : nullptr;
+    std::vector<double> distances(keys.size() / 2, DTW_EXCEEDS_BOUND);
+    if (!query || !reference_store.isOpen() || query->dims != reference_store.dims()) {
+        return typedArrayCopy("Float64Array", distances);
+    }
+    
+    const int mode = entry->mode;
+    bool quantized = reference_store.payloadType() == PAYLOAD_INT8 && mode == PREPROCESS_NONE;
+    QuantizationParams params;
+    QuantizedMatrix<int8_t> quantized_query;
+    if (quantized) {
+        params.dims = reference_store.dims();
+        params.scale.assign(reference_store.quantizationScales(), reference_store.quantizationScales() + params.dims);
+        params.offset.assign(reference_store.quantizationOffsets(), reference_store.quantizationOffsets() + params.dims);
+        quantized_query = quantizeFeatures<int8_t>(*query, params);
+    }
+    
+    DTWWorkspace workspace;
+    for (size_t k = 0; k < distances.size(); k++) {
+        const VerseEntry* verse = reference_store.findVerse(keys[2 * k], keys[2 * k + 1]);
+        if (!verse || verse->frame_count == 0) continue;
+        
+        if (quantized) {
+            distances[k] = computeDTWQuantized(quantized_query.data.data(), quantized_query.rows,
+                                               reference_store.int8Frames(verse->frame_offset), verse->frame_count,
+                                               params, max_distance, band_width, workspace);
+        } else {
+            FeatureMatrix reference = reference_store.frames(verse->frame_offset, verse->frame_count);
+            if (mode != PREPROCESS_NONE) reference = preprocessFeatures(reference, mode);
+            distances[k] = computeDTWBounded(*query, reference, max_distance, band_width, EUCLIDEAN, workspace);
+        }
+    }
+    
+    return typedArrayCopy("Float64Array", distances);
+}
+
+emscripten::val feature_store_info() {
+    emscripten::val info = emscripten::val::object();
+    info.set("open", reference_store.isOpen());
+    info.set("dims", reference_store.dims());
+    info.set("verses", reference_store.verseCount());
+    info.set("words", reference_store.wordCount());
+    info.set("frames", reference_store.totalFrames());
+    info.set("payload", reference_store.payloadType() == PAYLOAD_INT8 ? std::string("int8") : std::string("float32"));
+    info.set("configHash", featureConfigHashHex(reference_store.configHash()));
+    return info;
+}
+
+// Decode one verse (word == 0) or one word into a sequence handle; -1 if absent
+int feature_store_lookup(int surah, int ayah, int word) {
+    uint32_t frame_offset, frame_count;
+    if (word == 0) {
+        const VerseEntry* verse = reference_store.findVerse(surah, ayah);
+        if (!verse) return -1;
+        frame_offset = verse->frame_offset;
+        frame_count = verse->frame_count;
+    } else {
+        const WordEntry* entry = reference_store.findWord(surah, ayah, word);
+        if (!entry) return -1;
+        frame_offset = entry->frame_offset;
+        frame_count = entry->frame_count;
+    }
+    return registerSequence(reference_store.frames(frame_offset, frame_count));
+}
+
+// First frame of each word relative to the verse start, followed by the verse
+// frame count; empty if the verse is not in the store
+emscripten::val feature_store_word_boundaries(int surah, int ayah) {
+    std::vector<int32_t> boundaries;
+    if (const VerseEntry* verse = reference_store.findVerse(surah, ayah)) {
+        const WordEntry* words = reference_store.wordsOf(*verse);
+        for (uint32_t k = 0; k < verse->word_count; k++) {
+            boundaries.push_back(words[k].frame_offset - verse->frame_offset);
+        }
+        boundaries.push_back(verse->frame_count);
+    }
+    return typedArrayCopy("Int32Array", boundaries);
+}
+
 // Emscripten bindings
 EMSCRIPTEN_BINDINGS(dtw_processor) {
     emscripten::function("dtw_distance", &dtw_distance);
     emscripten::function("dtw_align", &dtw_align);
+    emscripten::function("dtw_align_pattern", &dtw_align_pattern);
+    emscripten::function("dtw_upload_sequence", &dtw_upload_sequence);
+    emscripten::function("dtw_upload_flat", &dtw_upload_flat);
+    emscripten::function("dtw_release_sequence", &dtw_release_sequence);
+    emscripten::function("dtw_set_preprocessing", &dtw_set_preprocessing);
+    emscripten::function("dtw_batch", &dtw_batch);
+    emscripten::function("dtw_align_words", &dtw_align_words);
+    emscripten::function("dtw_barycenter", &dtw_barycenter);
+    emscripten::function("dtw_within_bound", &dtw_within_bound);
+    emscripten::function("dtw_distance_parallel", &dtw_distance_parallel);
+    emscripten::function("dtw_subsequence", &dtw_subsequence);
+    emscripten::function("feature_store_buffer", &feature_store_buffer);
+    emscripten::function("feature_store_open", &feature_store_open);
+    emscripten::function("feature_store_info", &feature_store_info);
+    emscripten::function("feature_store_lookup", &feature_store_lookup);
+    emscripten::function("feature_store_word_boundaries", &feature_store_word_boundaries);
+    emscripten::function("feature_store_batch", &feature_store_batch);
+    
+    emscripten::class_<OnlineDTW>("OnlineDTW")
+        .constructor(&createOnlineDTW, emscripten::allow_raw_pointers())
+        .function("pushFrame", &onlineDTWPushFrame)
+        .function("position", &OnlineDTW::position)
+        .function("frameCount", &OnlineDTW::frameCount)
+        .function("cost", &OnlineDTW::cost)
+        .function("reset", &OnlineDTW::reset);
+    
+    emscripten::class_<DTWSession>("DTWSession")
+        .constructor(&createDTWSession, emscripten::allow_raw_pointers())
+        .function("replaceSuffix", &dtwSessionReplaceSuffix)
+        .function("distance", &DTWSession::distance)
+        .function("normalizedDistance", &DTWSession::normalizedDistance)
+        .function("queryRows", &DTWSession::queryRows)
+        .function("path", &dtwSessionPath);
     
     emscripten::register_vector<double>("VectorDouble");
     emscripten::register_vector<std::vector<double>>("VectorVectorDouble");
-}
\ No newline at end of file
+}
+
+#endif // __EMSCRIPTEN__
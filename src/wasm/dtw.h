@@ -0,0 +1,281 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <limits>
+
+// Dynamic Time Warping for Audio Alignment
+// Shared by the WebAssembly module (dtw.cpp bindings) and native tools.
+
+class ThreadPool;
+
+// Distance metrics
+enum DistanceMetric {
+    EUCLIDEAN,
+    MANHATTAN,
+    COSINE
+};
+
+// Local distances are computed in tiles over contiguous feature matrices rather
+// than per (i, j) pair. A 32x64 tile of doubles (16KB) stays in L1 together with
+// the packed reference frames it is computed from, and the 64-wide inner loop
+// runs over contiguous memory so the compiler can vectorise it.
+const int DISTANCE_TILE_ROWS = 32;
+const int DISTANCE_TILE_COLS = 64;
+
+// Feature sequence stored as one row-major block, one frame per row
+struct FeatureMatrix {
+    int rows = 0;
+    int dims = 0;
+    bool uniform = true;           // false if frames have different lengths
+    std::vector<double> data;      // rows x dims
+    std::vector<double> sq_norms;  // ||x||^2 per frame
+    std::vector<double> norms;     // ||x|| per frame
+
+    const double* row(int i) const { return data.data() + (size_t)i * dims; }
+    double* row(int i) { return data.data() + (size_t)i * dims; }
+
+    // Recompute sq_norms and norms after data has been written
+    void updateNorms();
+};
+
+// Pack a sequence into a FeatureMatrix and precompute its per-frame norms
+FeatureMatrix toFeatureMatrix(const std::vector<std::vector<double>>& sequence);
+
+// Per-sequence preprocessing before alignment. The flags combine; z-normalization
+// is applied first, so PREPROCESS_ZNORM | PREPROCESS_DERIVATIVE is derivative DTW
+// on normalized features. Both make the distance insensitive to level offsets
+// (loudness, vocal tract length) between a student and the reference reciter.
+enum FeaturePreprocessing {
+    PREPROCESS_NONE = 0,
+    PREPROCESS_ZNORM = 1,       // every dimension to zero mean, unit variance over the sequence
+    PREPROCESS_DERIVATIVE = 2   // frames replaced by their local slope (derivative DTW)
+};
+const int PREPROCESS_MODES = 4;
+
+// Each dimension shifted and scaled to zero mean and unit variance over the
+// sequence; constant dimensions are only centred
+FeatureMatrix zNormalizeFeatures(const FeatureMatrix& features);
+
+// Derivative DTW estimate (Keogh & Pazzani): d[i] = ((x[i] - x[i-1]) + (x[i+1] - x[i-1]) / 2) / 2,
+// with the first and last frame copying their neighbour's slope
+FeatureMatrix derivativeFeatures(const FeatureMatrix& features);
+
+// Apply a combination of FeaturePreprocessing flags; ragged matrices are returned unchanged
+FeatureMatrix preprocessFeatures(const FeatureMatrix& features, int mode);
+
+// Compute local distances for rows [i0, i1) of a against rows [j0, j1) of b.
+// out[(i - i0) * out_stride + (j - j0)] receives the distance between a[i] and b[j].
+void computeDistanceBlock(const FeatureMatrix& a, int i0, int i1,
+                          const FeatureMatrix& b, int j0, int j1,
+                          DistanceMetric metric, double* out, int out_stride);
+
+// DTW with Sakoe-Chiba band constraint
+struct DTWResult {
+    double distance;
+    double normalized_distance;                   // distance divided by the path weight
+    std::vector<std::pair<int, int>> path;
+    std::vector<std::vector<double>> cost_matrix; // only filled by computeDTW
+};
+
+DTWResult computeDTW(const std::vector<std::vector<double>>& sequence1,
+                     const std::vector<std::vector<double>>& sequence2,
+                     int band_width = -1,
+                     DistanceMetric metric = EUCLIDEAN,
+                     bool return_path = true);
+
+// Step patterns and global constraints selectable at runtime. The templates
+// behind them live in dtw_step_patterns.h; this dispatches once per call.
+enum StepPatternType {
+    SYMMETRIC1,
+    SYMMETRIC2,
+    ASYMMETRIC,
+    SYMMETRIC_P1,
+    RABINER_JUANG_IIID
+};
+
+enum WindowType {
+    NO_WINDOW,
+    SAKOE_CHIBA,    // window_param: band width in frames
+    ITAKURA         // window_param: maximum slope (> 1)
+};
+
+DTWResult computeDTWConstrained(const FeatureMatrix& a,
+                                const FeatureMatrix& b,
+                                StepPatternType pattern,
+                                WindowType window,
+                                double window_param,
+                                DistanceMetric metric = EUCLIDEAN,
+                                bool return_path = true);
+
+// Distance-only DTW computed in anti-diagonal waves of tiles on a thread pool.
+// Gives bit-identical distances to computeDTW for the same inputs.
+double computeDTWParallel(const FeatureMatrix& a,
+                          const FeatureMatrix& b,
+                          int band_width,
+                          DistanceMetric metric,
+                          ThreadPool& pool);
+
+// Distance-only DTW that gives up as soon as the result is known to exceed
+// upper_bound: every warping path crosses every row, so once all cells of a row
+// (within the band) are above the bound the final distance is too. Returns
+// DTW_EXCEEDS_BOUND in that case. With an infinite bound this is plain DTW in
+// O(m) memory.
+const double DTW_EXCEEDS_BOUND = std::numeric_limits<double>::infinity();
+
+// Scratch buffers reused across alignments, e.g. one query against many references
+struct DTWWorkspace {
+    std::vector<double> local_distances;
+    std::vector<double> prev_row;
+    std::vector<double> cur_row;
+};
+
+double computeDTWBounded(const FeatureMatrix& a,
+                         const FeatureMatrix& b,
+                         double upper_bound,
+                         int band_width,
+                         DistanceMetric metric,
+                         DTWWorkspace& workspace);
+
+double computeDTWBounded(const FeatureMatrix& a,
+                         const FeatureMatrix& b,
+                         double upper_bound,
+                         int band_width = -1,
+                         DistanceMetric metric = EUCLIDEAN);
+
+// Per-dimension min/max of the query over the Sakoe-Chiba window around each
+// reference frame, for the LB_Keogh lower bound. Covers reference frames
+// [0, length); later frames have no admissible query row.
+struct QueryEnvelope {
+    int dims = 0;
+    int length = 0;
+    std::vector<double> upper;  // length x dims
+    std::vector<double> lower;  // length x dims
+};
+
+QueryEnvelope computeQueryEnvelope(const FeatureMatrix& query, int band_width);
+
+// LB_Keogh for Euclidean DTW: each reference frame is charged its distance to
+// the query envelope. Stops summing once the bound exceeds upper_bound.
+double lowerBoundKeogh(const QueryEnvelope& envelope, const FeatureMatrix& reference, double upper_bound);
+
+// Align one query against many references, sharing the query's norms, envelope
+// and scratch buffers. With a finite max_distance, references whose LB_Keogh or
+// early-abandoned DTW exceeds it get DTW_EXCEEDS_BOUND. When paths is non-null
+// it receives the warping path of every reference within the bound.
+std::vector<double> computeDTWBatch(const FeatureMatrix& query,
+                                    const std::vector<const FeatureMatrix*>& references,
+                                    int band_width = -1,
+                                    DistanceMetric metric = EUCLIDEAN,
+                                    double max_distance = std::numeric_limits<double>::infinity(),
+                                    std::vector<std::vector<std::pair<int, int>>>* paths = nullptr);
+
+// DTW Barycenter Averaging (Petitjean et al., 2011): starting from the medoid,
+// repeatedly align every sequence to the running average and replace each
+// average frame by the mean of the frames aligned to it. Sequences whose frame
+// size differs from the medoid's are ignored.
+FeatureMatrix computeDBA(const std::vector<FeatureMatrix>& sequences,
+                         int max_iterations = 10,
+                         int band_width = -1);
+
+// Summarise several reference recitations of the same verse as num_templates
+// representative averages: sequences are split around the medoid and the
+// sequence farthest from it, then each group is averaged with DBA.
+std::vector<FeatureMatrix> buildReferenceTemplates(const std::vector<FeatureMatrix>& sequences,
+                                                   int num_templates = 1,
+                                                   int max_iterations = 10,
+                                                   int band_width = -1);
+
+// Word-level view of an alignment. word_boundaries holds the first reference
+// frame of every word followed by the reference length, as stored in the
+// reference feature store. The path is walked once; local distances are
+// recomputed per path run with computeDistanceBlock, so the path never has to
+// leave C++.
+struct WordSegment {
+    int start;              // first query frame aligned to the word, -1 if none
+    int end;                // last query frame aligned to the word (inclusive)
+    double average_cost;    // mean local distance over the path steps in the word
+    double duration_ratio;  // query frames / reference frames of the word
+};
+
+std::vector<WordSegment> segmentWords(const FeatureMatrix& query,
+                                      const FeatureMatrix& reference,
+                                      const std::vector<std::pair<int, int>>& path,
+                                      const std::vector<int>& word_boundaries,
+                                      DistanceMetric metric = EUCLIDEAN);
+
+// Subsequence DTW: locate a short query (e.g. one verse template) anywhere
+// inside a longer series (e.g. a multi-ayah recording). The start and end on
+// the series axis are free; only the query must be matched completely.
+struct SubsequenceMatch {
+    int start;       // first series frame of the match
+    int end;         // last series frame of the match (inclusive)
+    double distance;
+};
+
+std::vector<SubsequenceMatch> computeSubsequenceDTW(const std::vector<std::vector<double>>& query,
+                                                    const std::vector<std::vector<double>>& series,
+                                                    int num_matches = 1,
+                                                    DistanceMetric metric = EUCLIDEAN);
+
+// Online time warping: follow a live recording against a preloaded reference.
+// Frames arrive one at a time; only the current DP row is kept, restricted to a
+// window of reference frames around the last estimated position, so each frame
+// costs O(window) and memory does not grow with the length of the recording.
+class OnlineDTW {
+private:
+    FeatureMatrix reference;
+    FeatureMatrix frame_buffer;    // the incoming user frame as a 1-row matrix
+    std::vector<double> local_row; // its distances to the reference window
+    DistanceMetric metric;
+    int window;
+
+    std::vector<double> prev_row;  // costs of the previous user frame
+    std::vector<double> cur_row;
+    int prev_start;                // reference index of prev_row[0]
+    int frames;                    // user frames consumed so far
+    int current_position;
+    double current_cost;
+
+public:
+    OnlineDTW(const std::vector<std::vector<double>>& reference_frames, int window_size, DistanceMetric metric = EUCLIDEAN);
+
+    void reset();
+
+    // Consume one user frame and return the reference frame it is aligned to;
+    // -1, with the alignment unchanged, if its dimension differs from the reference
+    int pushFrame(const std::vector<double>& frame);
+
+    int position() const { return current_position; }
+    int frameCount() const { return frames; }
+    double cost() const { return current_cost; }
+};
+
+// Incremental DTW of an edited query against a fixed reference, e.g. a verse
+// recited word by word where the student retries the last word. The full cost
+// matrix is kept, and since row i only depends on rows <= i, replacing the query
+// from row r on recomputes rows r.. only: a retry costs O(retried frames x band)
+// instead of a whole realignment. Distances and paths match computeDTW.
+class DTWSession {
+private:
+    FeatureMatrix reference;
+    FeatureMatrix query;
+    int band;                              // <= 0: unconstrained
+    DistanceMetric metric;
+    std::vector<double> cost;              // query.rows x reference.rows
+    std::vector<double> local_distances;   // DISTANCE_TILE_ROWS x reference.rows
+
+public:
+    DTWSession(const FeatureMatrix& reference_frames, int band_width = -1, DistanceMetric metric = EUCLIDEAN);
+
+    // Keep query frames [0, keep_rows) and append `frames` after them (an empty
+    // matrix truncates). Returns the updated distance, or +inf and leaves the
+    // session unchanged if the frame size does not match the reference.
+    double replaceSuffix(int keep_rows, const FeatureMatrix& frames);
+
+    double distance() const;
+    double normalizedDistance() const;
+    std::vector<std::pair<int, int>> path() const;
+    int queryRows() const { return query.rows; }
+};
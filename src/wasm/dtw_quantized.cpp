@@ -0,0 +1,205 @@
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include "dtw_quantized.h"
+
+// Quantized feature DTW: int8/int16 frames, weighted float dot-product kernels
+
+template <typename T>
+QuantizationParams fitQuantization(const std::vector<const FeatureMatrix*>& corpus) {
+    QuantizationParams params;
+    for (const FeatureMatrix* features : corpus) {
+        if (features && features->uniform && features->rows > 0) {
+            params.dims = features->dims;
+            break;
+        }
+    }
+
+    const int dims = params.dims;
+    std::vector<double> lo(dims, std::numeric_limits<double>::infinity());
+    std::vector<double> hi(dims, -std::numeric_limits<double>::infinity());
+    for (const FeatureMatrix* features : corpus) {
+        if (!features || !features->uniform || features->dims != dims) continue;
+        for (int i = 0; i < features->rows; i++) {
+            const double* frame = features->row(i);
+            for (int d = 0; d < dims; d++) {
+                lo[d] = std::min(lo[d], frame[d]);
+                hi[d] = std::max(hi[d], frame[d]);
+            }
+        }
+    }
+
+    params.scale.assign(dims, 1.0f);
+    params.offset.assign(dims, 0.0f);
+    for (int d = 0; d < dims; d++) {
+        if (lo[d] > hi[d]) continue;
+        params.offset[d] = static_cast<float>((lo[d] + hi[d]) / 2.0);
+        if (hi[d] > lo[d]) {
+            params.scale[d] = static_cast<float>((hi[d] - lo[d]) / (2.0 * quantizedRange<T>()));
+        }
+    }
+    return params;
+}
+
+template <typename T>
+QuantizedMatrix<T> quantizeFeatures(const FeatureMatrix& features, const QuantizationParams& params) {
+    QuantizedMatrix<T> quantized;
+    if (!features.uniform || features.dims != params.dims) {
+        return quantized;
+    }
+
+    const int dims = params.dims;
+    const long range = quantizedRange<T>();
+    quantized.rows = features.rows;
+    quantized.dims = dims;
+    quantized.data.resize((size_t)features.rows * dims);
+
+    for (int i = 0; i < features.rows; i++) {
+        const double* frame = features.row(i);
+        T* out = quantized.data.data() + (size_t)i * dims;
+        for (int d = 0; d < dims; d++) {
+            long q = lround((frame[d] - params.offset[d]) / params.scale[d]);
+            out[d] = static_cast<T>(std::max(-range, std::min(range, q)));
+        }
+    }
+    return quantized;
+}
+
+// Local distances for rows [i0, i1) of a against rows [j0, j1) of b, written
+// like computeDistanceBlock. With w[d] = scale[d]^2 the squared distance is
+// sum_d w[d] (qa - qb)^2 = |qa|_w^2 + |qb|_w^2 - 2 sum_d (w[d] qa) qb, so the
+// per-cell work is one float dot product against a packed tile of b, decoded
+// from int8/int16 once per tile.
+template <typename T>
+static void computeQuantizedDistanceBlock(const T* a, int i0, int i1,
+                                          const T* b, int j0, int j1,
+                                          const std::vector<float>& weights,
+                                          double* out, int out_stride) {
+    const int dims = weights.size();
+    thread_local std::vector<float> packed, weighted_row;
+    packed.resize((size_t)dims * DISTANCE_TILE_COLS);
+    weighted_row.resize(dims);
+    float packed_norms[DISTANCE_TILE_COLS];
+    float acc[DISTANCE_TILE_COLS];
+
+    for (int jt = j0; jt < j1; jt += DISTANCE_TILE_COLS) {
+        const int cols = std::min(DISTANCE_TILE_COLS, j1 - jt);
+
+        std::fill(packed_norms, packed_norms + cols, 0.0f);
+        for (int c = 0; c < cols; c++) {
+            const T* frame = b + (size_t)(jt + c) * dims;
+            for (int d = 0; d < dims; d++) {
+                const float value = frame[d];
+                packed[(size_t)d * DISTANCE_TILE_COLS + c] = value;
+                packed_norms[c] += weights[d] * value * value;
+            }
+        }
+
+        for (int i = i0; i < i1; i++) {
+            const T* x = a + (size_t)i * dims;
+            float row_norm = 0.0f;
+            for (int d = 0; d < dims; d++) {
+                weighted_row[d] = weights[d] * x[d];
+                row_norm += weighted_row[d] * x[d];
+            }
+
+            std::fill(acc, acc + cols, 0.0f);
+            for (int d = 0; d < dims; d++) {
+                const float xd = weighted_row[d];
+                const float* p = packed.data() + (size_t)d * DISTANCE_TILE_COLS;
+                for (int c = 0; c < cols; c++) {
+                    acc[c] += xd * p[c];
+                }
+            }
+
+            double* dst = out + (size_t)(i - i0) * out_stride + (jt - j0);
+            for (int c = 0; c < cols; c++) {
+                dst[c] = std::sqrt(std::max(0.0f, row_norm + packed_norms[c] - 2.0f * acc[c]));
+            }
+        }
+    }
+}
+
+template <typename T>
+double computeDTWQuantized(const T* a, int n,
+                           const T* b, int m,
+                           const QuantizationParams& params,
+                           double upper_bound,
+                           int band_width,
+                           DTWWorkspace& workspace) {
+    const double INF = std::numeric_limits<double>::infinity();
+    if (n == 0 || m == 0 || params.dims == 0) {
+        return INF;
+    }
+
+    if (band_width <= 0) {
+        band_width = std::max(n, m);
+    }
+
+    // scale^2 turns squared code differences back into squared feature units
+    thread_local std::vector<float> weights;
+    weights.resize(params.dims);
+    for (int d = 0; d < params.dims; d++) {
+        weights[d] = params.scale[d] * params.scale[d];
+    }
+
+    std::vector<double>& local_distances = workspace.local_distances;
+    std::vector<double>& prev_row = workspace.prev_row;
+    std::vector<double>& cur_row = workspace.cur_row;
+    local_distances.resize((size_t)DISTANCE_TILE_ROWS * m);
+    prev_row.assign(m, INF);
+    cur_row.assign(m, INF);
+
+    for (int i = 0; i < n; i++) {
+        int j_start = std::max(0, i - band_width);
+        int j_end = std::min(m, i + band_width + 1);
+        if (j_start >= j_end) return INF;
+
+        if (i % DISTANCE_TILE_ROWS == 0) {
+            int i1 = std::min(n, i + DISTANCE_TILE_ROWS);
+            int block_end = std::min(m, i1 - 1 + band_width + 1);
+            computeQuantizedDistanceBlock(a, i, i1, b, j_start, block_end, weights,
+                                          local_distances.data() + j_start, m);
+        }
+        const double* local = local_distances.data() + (size_t)(i % DISTANCE_TILE_ROWS) * m;
+
+        if (j_start > 0) cur_row[j_start - 1] = INF;
+
+        double row_min = INF;
+        for (int j = j_start; j < j_end; j++) {
+            double min_prev;
+            if (i == 0) {
+                min_prev = (j == 0) ? 0.0 : cur_row[j-1];
+            } else {
+                min_prev = prev_row[j];
+                if (j > 0) {
+                    min_prev = std::min(min_prev, prev_row[j-1]);
+                    min_prev = std::min(min_prev, cur_row[j-1]);
+                }
+            }
+
+            cur_row[j] = local[j] + min_prev;
+            row_min = std::min(row_min, cur_row[j]);
+        }
+
+        if (row_min > upper_bound) {
+            return DTW_EXCEEDS_BOUND;
+        }
+
+        if (j_end < m) cur_row[j_end] = INF;
+        std::swap(prev_row, cur_row);
+    }
+
+    double distance = prev_row[m-1];
+    return distance > upper_bound ? DTW_EXCEEDS_BOUND : distance;
+}
+
+template QuantizationParams fitQuantization<int8_t>(const std::vector<const FeatureMatrix*>&);
+template QuantizationParams fitQuantization<int16_t>(const std::vector<const FeatureMatrix*>&);
+template QuantizedMatrix<int8_t> quantizeFeatures<int8_t>(const FeatureMatrix&, const QuantizationParams&);
+template QuantizedMatrix<int16_t> quantizeFeatures<int16_t>(const FeatureMatrix&, const QuantizationParams&);
+template double computeDTWQuantized<int8_t>(const int8_t*, int, const int8_t*, int, const QuantizationParams&,
+                                            double, int, DTWWorkspace&);
+template double computeDTWQuantized<int16_t>(const int16_t*, int, const int16_t*, int, const QuantizationParams&,
+                                             double, int, DTWWorkspace&);
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <limits>
+#include "dtw.h"
+
+// Quantized feature DTW
+//
+// MFCC frames quantized per dimension to int8 or int16 take 1/8 or 1/4 of the
+// memory (and bandwidth) of double frames. Each coefficient is stored as
+// q = round((x - offset[d]) / scale[d]) in [-Q, Q]. This is the same mapping as
+// int8 payloads in the reference feature store, so store frames are used as is.
+//
+// The local distance is Euclidean like computeDTW, measured on the codes with
+// per-dimension weights scale[d]^2 (the offsets cancel). Codes are widened to
+// float once per reference tile and the per-cell work is a single float dot
+// product. The gain is in memory footprint, not compute: the band recurrence is
+// the same as the double kernel's, and alignments run at about the speed of
+// computeDTWBounded (within 0.8-1.2x in tools/quantized_dtw_report.cpp, which
+// also measures the accuracy delta). Integer accumulation (int32 for int8,
+// int64 for int16) needs integer per-dimension weights; it was slower and, for
+// int16, less accurate than the float dot product.
+
+struct QuantizationParams {
+    int dims = 0;
+    std::vector<float> scale;   // x ~= q * scale[d] + offset[d]
+    std::vector<float> offset;
+};
+
+template <typename T>
+struct QuantizedMatrix {
+    int rows = 0;
+    int dims = 0;
+    std::vector<T> data;        // rows x dims
+
+    const T* row(int i) const { return data.data() + (size_t)i * dims; }
+};
+
+// Largest magnitude used for a quantized coefficient (symmetric range)
+template <typename T>
+constexpr int quantizedRange() { return std::numeric_limits<T>::max(); }
+
+// Per-dimension scale and offset covering the min/max of a corpus
+template <typename T>
+QuantizationParams fitQuantization(const std::vector<const FeatureMatrix*>& corpus);
+
+// Quantize with the given parameters; values outside the fitted range saturate
+template <typename T>
+QuantizedMatrix<T> quantizeFeatures(const FeatureMatrix& features, const QuantizationParams& params);
+
+// Distance-only DTW on quantized frames (a: n x dims, b: m x dims) with the same
+// Sakoe-Chiba band and early abandoning as computeDTWBounded
+template <typename T>
+double computeDTWQuantized(const T* a, int n,
+                           const T* b, int m,
+                           const QuantizationParams& params,
+                           double upper_bound,
+                           int band_width,
+                           DTWWorkspace& workspace);
+
+template <typename T>
+double computeDTWQuantized(const QuantizedMatrix<T>& a,
+                           const QuantizedMatrix<T>& b,
+                           const QuantizationParams& params,
+                           double upper_bound = std::numeric_limits<double>::infinity(),
+                           int band_width = -1) {
+    DTWWorkspace workspace;
+    return computeDTWQuantized(a.data.data(), a.rows, b.data.data(), b.rows, params, upper_bound, band_width, workspace);
+}
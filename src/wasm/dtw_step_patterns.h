@@ -0,0 +1,237 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include "dtw.h"
+
+// Compile-time DTW step patterns and global constraints
+//
+// A step pattern computes the cumulative cost of cell (i, j) from its
+// predecessors, and says how to normalise the final distance. Each pattern is
+// its own type, so computeDTWPattern<Pattern, Window> is a separate instantiation
+// and the inner loop has no branching on the pattern.
+//
+// Cost and local-distance matrices are padded with two rows and columns of +inf,
+// so predecessors up to (i-2, j-2) can be read without bounds checks. `idx` is
+// the padded index of (i, j) and `W` the padded row stride (m + 2).
+//
+// STEPS lists, per choice, the offset to the predecessor and the offset to the
+// cell passed through on the way (0, 0 when the step is direct). The backtrack
+// uses it to rebuild the path.
+
+// symmetric1: min of diagonal, vertical, horizontal, unweighted (classic DTW)
+struct Symmetric1 {
+    static constexpr int STEPS[3][4] = {{-1, -1, 0, 0}, {-1, 0, 0, 0}, {0, -1, 0, 0}};
+
+    static double step(const double* D, const double* d, size_t idx, int W, int& choice) {
+        double best = D[idx - W - 1];
+        choice = 0;
+        if (D[idx - W] < best) { best = D[idx - W]; choice = 1; }
+        if (D[idx - 1] < best) { best = D[idx - 1]; choice = 2; }
+        return best + d[idx];
+    }
+
+    // Path length is not fixed, so keep the historic max(n, m)
+    static double normalization(int n, int m) { return std::max(n, m); }
+};
+
+// symmetric2: diagonal steps weigh twice, so every path has weight n + m
+struct Symmetric2 {
+    static constexpr int STEPS[3][4] = {{-1, -1, 0, 0}, {-1, 0, 0, 0}, {0, -1, 0, 0}};
+
+    static double step(const double* D, const double* d, size_t idx, int W, int& choice) {
+        double best = D[idx - W - 1] + 2.0 * d[idx];
+        choice = 0;
+        double up = D[idx - W] + d[idx];
+        double left = D[idx - 1] + d[idx];
+        if (up < best) { best = up; choice = 1; }
+        if (left < best) { best = left; choice = 2; }
+        return best;
+    }
+
+    static double normalization(int n, int m) { return n + m; }
+};
+
+// asymmetric: every step advances the query (rows) by exactly one frame, and the
+// reference by 0, 1 or 2. Path weight is n.
+struct Asymmetric {
+    static constexpr int STEPS[3][4] = {{-1, -1, 0, 0}, {-1, 0, 0, 0}, {-1, -2, 0, 0}};
+
+    static double step(const double* D, const double* d, size_t idx, int W, int& choice) {
+        double best = D[idx - W - 1];
+        choice = 0;
+        if (D[idx - W] < best) { best = D[idx - W]; choice = 1; }
+        if (D[idx - W - 2] < best) { best = D[idx - W - 2]; choice = 2; }
+        return best + d[idx];
+    }
+
+    static double normalization(int n, int /*m*/) { return n; }
+};
+
+// symmetricP1: Sakoe-Chiba slope constraint P = 1 (Rabiner & Juang, sec. 4.7).
+// At most one horizontal or vertical move between diagonals; path weight n + m.
+struct SymmetricP1 {
+    static constexpr int STEPS[3][4] = {{-1, -1, 0, 0}, {-1, -2, 0, -1}, {-2, -1, -1, 0}};
+
+    static double step(const double* D, const double* d, size_t idx, int W, int& choice) {
+        double best = D[idx - W - 1] + 2.0 * d[idx];
+        choice = 0;
+        double wide = D[idx - W - 2] + 2.0 * d[idx - 1] + d[idx];
+        double tall = D[idx - 2 * W - 1] + 2.0 * d[idx - W] + d[idx];
+        if (wide < best) { best = wide; choice = 1; }
+        if (tall < best) { best = tall; choice = 2; }
+        return best;
+    }
+
+    static double normalization(int n, int m) { return n + m; }
+};
+
+// Rabiner-Juang type III local constraint with type (d) slope weighting:
+// direct (1,1), (1,2), (2,1) jumps weighted by the Manhattan length of the step.
+struct RabinerJuangIIId {
+    static constexpr int STEPS[3][4] = {{-1, -1, 0, 0}, {-1, -2, 0, 0}, {-2, -1, 0, 0}};
+
+    static double step(const double* D, const double* d, size_t idx, int W, int& choice) {
+        double best = D[idx - W - 1] + 2.0 * d[idx];
+        choice = 0;
+        double wide = D[idx - W - 2] + 3.0 * d[idx];
+        double tall = D[idx - 2 * W - 1] + 3.0 * d[idx];
+        if (wide < best) { best = wide; choice = 1; }
+        if (tall < best) { best = tall; choice = 2; }
+        return best;
+    }
+
+    static double normalization(int n, int m) { return n + m; }
+};
+
+// Global constraints: rowRange gives the admissible columns [j_start, j_end) of row i
+
+struct NoWindow {
+    int m;
+
+    void rowRange(int /*i*/, int& j_start, int& j_end) const {
+        j_start = 0;
+        j_end = m;
+    }
+};
+
+// Sakoe-Chiba band: |i - j| <= band
+struct SakoeChibaWindow {
+    int m;
+    int band;
+
+    void rowRange(int i, int& j_start, int& j_end) const {
+        j_start = std::max(0, i - band);
+        j_end = std::min(m, i + band + 1);
+    }
+};
+
+// Itakura parallelogram: in coordinates normalised to [0, 1] the path slope is
+// kept between 1/max_slope and max_slope, measured from both corners
+struct ItakuraWindow {
+    int n;
+    int m;
+    double max_slope;
+
+    void rowRange(int i, int& j_start, int& j_end) const {
+        if (n == 1 || m == 1 || max_slope <= 1.0) {
+            j_start = 0;
+            j_end = m;
+            return;
+        }
+
+        const double eps = 1e-9;
+        double x = static_cast<double>(i) / (n - 1);
+        double lower = std::max(x / max_slope, 1.0 - max_slope * (1.0 - x));
+        double upper = std::min(max_slope * x, 1.0 - (1.0 - x) / max_slope);
+
+        j_start = std::max(0, static_cast<int>(std::ceil(lower * (m - 1) - eps)));
+        j_end = std::min(m, static_cast<int>(std::floor(upper * (m - 1) + eps)) + 1);
+    }
+};
+
+template <class Pattern, class Window>
+DTWResult computeDTWPattern(const FeatureMatrix& a,
+                            const FeatureMatrix& b,
+                            const Window& window,
+                            DistanceMetric metric = EUCLIDEAN,
+                            bool return_path = true) {
+    const double INF = std::numeric_limits<double>::infinity();
+    const int n = a.rows;
+    const int m = b.rows;
+
+    DTWResult result;
+    result.distance = INF;
+    result.normalized_distance = INF;
+    if (n == 0 || m == 0) {
+        return result;
+    }
+
+    const int W = m + 2;
+    auto at = [W](int i, int j) { return (size_t)(i + 2) * W + (j + 2); };
+
+    std::vector<double> D((size_t)(n + 2) * W, INF);
+    std::vector<double> d((size_t)(n + 2) * W, INF);
+    std::vector<unsigned char> choices(return_path ? (size_t)n * m : 0);
+
+    // Local distances, one block of rows at a time over the union of their ranges
+    for (int i0 = 0; i0 < n; i0 += DISTANCE_TILE_ROWS) {
+        int i1 = std::min(n, i0 + DISTANCE_TILE_ROWS);
+        int lo = m, hi = 0;
+        for (int i = i0; i < i1; i++) {
+            int j_start, j_end;
+            window.rowRange(i, j_start, j_end);
+            if (j_start < j_end) {
+                lo = std::min(lo, j_start);
+                hi = std::max(hi, j_end);
+            }
+        }
+        if (lo < hi) {
+            computeDistanceBlock(a, i0, i1, b, lo, hi, metric, &d[at(i0, lo)], W);
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        int j_start, j_end;
+        window.rowRange(i, j_start, j_end);
+
+        for (int j = j_start; j < j_end; j++) {
+            size_t idx = at(i, j);
+            if (i == 0 && j == 0) {
+                D[idx] = d[idx];
+                continue;
+            }
+
+            int choice;
+            D[idx] = Pattern::step(D.data(), d.data(), idx, W, choice);
+            if (return_path) {
+                choices[(size_t)i * m + j] = static_cast<unsigned char>(choice);
+            }
+        }
+    }
+
+    result.distance = D[at(n - 1, m - 1)];
+    result.normalized_distance = result.distance / Pattern::normalization(n, m);
+
+    if (return_path && result.distance != INF) {
+        int i = n - 1;
+        int j = m - 1;
+        result.path.push_back({i, j});
+
+        while (i > 0 || j > 0) {
+            const int* step = Pattern::STEPS[choices[(size_t)i * m + j]];
+            if (step[2] != 0 || step[3] != 0) {
+                result.path.push_back({i + step[2], j + step[3]});
+            }
+            i += step[0];
+            j += step[1];
+            result.path.push_back({i, j});
+        }
+
+        std::reverse(result.path.begin(), result.path.end());
+    }
+
+    return result;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Feature front-end configuration
+// Every reference feature store records the hash of the configuration it was
+// built with, so features computed with different framing or filter banks are
+// never compared against each other.
+
+struct FeatureConfig {
+    double sample_rate;
+    int frame_length;
+    int hop_size;
+    int num_mel_filters;
+    int num_coeffs;
+    double pre_emphasis;
+};
+
+// 64-bit FNV-1a over a canonical text form of the configuration
+inline uint64_t featureConfigHash(const FeatureConfig& config) {
+    char text[160];
+    int length = snprintf(text, sizeof(text), "mfcc-v1|sr=%.3f|frame=%d|hop=%d|mel=%d|coeffs=%d|pre=%.6f",
+                          config.sample_rate, config.frame_length, config.hop_size,
+                          config.num_mel_filters, config.num_coeffs, config.pre_emphasis);
+
+    uint64_t hash = 1469598103934665603ULL;
+    for (int i = 0; i < length; i++) {
+        hash ^= static_cast<unsigned char>(text[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Hex form for JavaScript, which cannot hold a 64-bit integer exactly
+inline std::string featureConfigHashHex(uint64_t hash) {
+    char text[17];
+    snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
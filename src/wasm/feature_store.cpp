@@ -0,0 +1,384 @@
+#include <cmath>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include "feature_store.h"
+
+#ifndef __EMSCRIPTEN__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// Binary reference feature store: reader and writer
+
+static const size_t SECTION_ALIGNMENT = 64;
+
+static size_t alignSection(size_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+static bool fail(std::string* error, const char* message) {
+    if (error) *error = message;
+    return false;
+}
+
+template <typename Entry>
+static bool keyLess(const Entry& entry, int surah, int ayah) {
+    return entry.surah < surah || (entry.surah == surah && entry.ayah < ayah);
+}
+
+FeatureStore::~FeatureStore() {
+    close();
+}
+
+bool FeatureStore::open(const uint8_t* data, size_t length, std::string* error) {
+    close();
+    base = data;
+    size = length;
+    if (!parse(error)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool FeatureStore::open(std::vector<uint8_t>&& data, std::string* error) {
+    close();
+    owned = std::move(data);
+    base = owned.data();
+    size = owned.size();
+    if (!parse(error)) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+#ifndef __EMSCRIPTEN__
+bool FeatureStore::openFile(const std::string& path, std::string* error) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return fail(error, "cannot open feature store file");
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return fail(error, "cannot stat feature store file");
+    }
+
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return fail(error, "cannot map feature store file");
+
+    mapping = mapped;
+    mapping_size = info.st_size;
+    base = static_cast<const uint8_t*>(mapped);
+    size = mapping_size;
+    if (!parse(error)) {
+        close();
+        return false;
+    }
+    return true;
+}
+#endif
+
+void FeatureStore::close() {
+#ifndef __EMSCRIPTEN__
+    if (mapping) {
+        munmap(mapping, mapping_size);
+    }
+#endif
+    mapping = nullptr;
+    mapping_size = 0;
+    owned.clear();
+    base = nullptr;
+    size = 0;
+    header = nullptr;
+    verses = nullptr;
+    words = nullptr;
+    scales = nullptr;
+    offsets = nullptr;
+}
+
+// Validate the header, that every section lies inside the buffer, and that the
+// index tables are sorted and consistent with each other
+bool FeatureStore::parse(std::string* error) {
+    if (size < sizeof(FeatureStoreHeader)) return fail(error, "feature store is truncated");
+
+    const FeatureStoreHeader* h = reinterpret_cast<const FeatureStoreHeader*>(base);
+    if (memcmp(h->magic, FEATURE_STORE_MAGIC, 4) != 0) return fail(error, "not a feature store (bad magic)");
+    if (h->version != FEATURE_STORE_VERSION) return fail(error, "unsupported feature store version");
+    if (h->payload_type != PAYLOAD_FLOAT32 && h->payload_type != PAYLOAD_INT8) return fail(error, "unknown payload type");
+    if (h->dims == 0) return fail(error, "feature store has no dimensions");
+    if (h->dims > FEATURE_STORE_MAX_DIMS) return fail(error, "feature store has too many dimensions");
+
+    // count elements of element_bytes each at offset; divides rather than
+    // multiplies so a crafted count cannot wrap
+    auto fits = [&](uint64_t offset, uint64_t count, uint64_t element_bytes) {
+        return offset % SECTION_ALIGNMENT == 0 && offset <= size && count <= (size - offset) / element_bytes;
+    };
+
+    const uint64_t frame_bytes = (uint64_t)h->dims * (h->payload_type == PAYLOAD_INT8 ? 1 : sizeof(float));
+    if (!fits(h->verse_index_offset, h->verse_count, sizeof(VerseEntry)) ||
+        !fits(h->word_index_offset, h->word_count, sizeof(WordEntry)) ||
+        !fits(h->payload_offset, h->total_frames, frame_bytes)) {
+        return fail(error, "feature store section out of bounds");
+    }
+    if (h->payload_type == PAYLOAD_INT8) {
+        if (!fits(h->quantization_offset, 2ULL * h->dims, sizeof(float))) {
+            return fail(error, "feature store quantization table out of bounds");
+        }
+        const float* table = reinterpret_cast<const float*>(base + h->quantization_offset);
+        for (uint32_t d = 0; d < h->dims; d++) {
+            if (!std::isfinite(table[d]) || table[d] == 0.0f || !std::isfinite(table[h->dims + d])) {
+                return fail(error, "feature store quantization table is invalid");
+            }
+        }
+    }
+
+    const VerseEntry* v = reinterpret_cast<const VerseEntry*>(base + h->verse_index_offset);
+    const WordEntry* w = reinterpret_cast<const WordEntry*>(base + h->word_index_offset);
+    for (uint32_t k = 0; k < h->verse_count; k++) {
+        if ((uint64_t)v[k].first_word + v[k].word_count > h->word_count ||
+            (uint64_t)v[k].frame_offset + v[k].frame_count > h->total_frames) {
+            return fail(error, "feature store verse entry out of range");
+        }
+        // findVerse and findWord binary-search these tables
+        if (k > 0 && !keyLess(v[k-1], v[k].surah, v[k].ayah)) {
+            return fail(error, "feature store verse index is not sorted");
+        }
+        const WordEntry* verse_words = w + v[k].first_word;
+        for (uint32_t i = 0; i < v[k].word_count; i++) {
+            const WordEntry& word = verse_words[i];
+            if (word.surah != v[k].surah || word.ayah != v[k].ayah || (i > 0 && word.word <= verse_words[i-1].word)) {
+                return fail(error, "feature store verse words are inconsistent");
+            }
+            if (word.frame_offset < v[k].frame_offset ||
+                (uint64_t)word.frame_offset + word.frame_count > (uint64_t)v[k].frame_offset + v[k].frame_count) {
+                return fail(error, "feature store word frames lie outside their verse");
+            }
+        }
+    }
+    for (uint32_t k = 0; k < h->word_count; k++) {
+        if ((uint64_t)w[k].frame_offset + w[k].frame_count > h->total_frames) {
+            return fail(error, "feature store word entry out of range");
+        }
+    }
+
+    header = h;
+    verses = v;
+    words = w;
+    if (h->payload_type == PAYLOAD_INT8) {
+        scales = reinterpret_cast<const float*>(base + h->quantization_offset);
+        offsets = scales + h->dims;
+    }
+    return true;
+}
+
+const VerseEntry* FeatureStore::findVerse(int surah, int ayah) const {
+    if (!header) return nullptr;
+    const VerseEntry* end = verses + header->verse_count;
+    const VerseEntry* it = std::lower_bound(verses, end, 0, [&](const VerseEntry& entry, int) {
+        return keyLess(entry, surah, ayah);
+    });
+    return (it != end && it->surah == surah && it->ayah == ayah) ? it : nullptr;
+}
+
+const WordEntry* FeatureStore::findWord(int surah, int ayah, int word) const {
+    const VerseEntry* verse = findVerse(surah, ayah);
+    if (!verse || word < 1) return nullptr;
+
+    const WordEntry* first = wordsOf(*verse);
+    const WordEntry* end = first + verse->word_count;
+    const WordEntry* it = std::lower_bound(first, end, word, [](const WordEntry& entry, int key) {
+        return entry.word < key;
+    });
+    return (it != end && it->word == word) ? it : nullptr;
+}
+
+const float* FeatureStore::float32Frames(uint32_t frame_offset) const {
+    if (!header || header->payload_type != PAYLOAD_FLOAT32) return nullptr;
+    return reinterpret_cast<const float*>(base + header->payload_offset) + (size_t)frame_offset * header->dims;
+}
+
+const int8_t* FeatureStore::int8Frames(uint32_t frame_offset) const {
+    if (!header || header->payload_type != PAYLOAD_INT8) return nullptr;
+    return reinterpret_cast<const int8_t*>(base + header->payload_offset) + (size_t)frame_offset * header->dims;
+}
+
+FeatureMatrix FeatureStore::frames(uint32_t frame_offset, uint32_t frame_count) const {
+    FeatureMatrix matrix;
+    if (!header || (uint64_t)frame_offset + frame_count > header->total_frames) return matrix;
+
+    int d_count = header->dims;
+    matrix.rows = frame_count;
+    matrix.dims = d_count;
+    matrix.data.resize((size_t)frame_count * d_count);
+
+    if (header->payload_type == PAYLOAD_FLOAT32) {
+        const float* src = float32Frames(frame_offset);
+        std::copy(src, src + matrix.data.size(), matrix.data.begin());
+    } else {
+        const int8_t* src = int8Frames(frame_offset);
+        for (uint32_t i = 0; i < frame_count; i++) {
+            for (int d = 0; d < d_count; d++) {
+                size_t k = (size_t)i * d_count + d;
+                matrix.data[k] = src[k] * scales[d] + offsets[d];
+            }
+        }
+    }
+
+    matrix.updateNorms();
+    return matrix;
+}
+
+FeatureStoreWriter::FeatureStoreWriter(int dims, uint64_t config_hash, FeaturePayloadType payload_type)
+    : dims(dims), config_hash(config_hash), payload_type(payload_type) {}
+
+bool FeatureStoreWriter::addWord(int surah, int ayah, int word, const FeatureMatrix& frames) {
+    if (frames.dims != dims || dims > (int)FEATURE_STORE_MAX_DIMS || !frames.uniform || surah < 1 || ayah < 1 || word < 1 ||
+        surah > 0xFFFF || ayah > 0xFFFF || word > 0xFFFF) {
+        return false;
+    }
+    pending.push_back({surah, ayah, word, frames});
+    return true;
+}
+
+std::vector<uint8_t> FeatureStoreWriter::serialize() const {
+    // Sort by key; for duplicate keys the entry added last wins
+    std::vector<size_t> order(pending.size());
+    for (size_t k = 0; k < order.size(); k++) order[k] = k;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const PendingWord& x = pending[a];
+        const PendingWord& y = pending[b];
+        if (x.surah != y.surah) return x.surah < y.surah;
+        if (x.ayah != y.ayah) return x.ayah < y.ayah;
+        return x.word < y.word;
+    });
+    std::vector<const PendingWord*> sorted;
+    for (size_t k : order) {
+        const PendingWord& entry = pending[k];
+        if (!sorted.empty() && sorted.back()->surah == entry.surah &&
+            sorted.back()->ayah == entry.ayah && sorted.back()->word == entry.word) {
+            sorted.back() = &entry;
+        } else {
+            sorted.push_back(&entry);
+        }
+    }
+
+    std::vector<WordEntry> word_index;
+    std::vector<VerseEntry> verse_index;
+    uint32_t total_frames = 0;
+    for (const PendingWord* entry : sorted) {
+        if (verse_index.empty() || verse_index.back().surah != entry->surah || verse_index.back().ayah != entry->ayah) {
+            VerseEntry verse = {};
+            verse.surah = entry->surah;
+            verse.ayah = entry->ayah;
+            verse.first_word = word_index.size();
+            verse.frame_offset = total_frames;
+            verse_index.push_back(verse);
+        }
+
+        WordEntry word = {};
+        word.surah = entry->surah;
+        word.ayah = entry->ayah;
+        word.word = entry->word;
+        word.frame_offset = total_frames;
+        word.frame_count = entry->frames.rows;
+        word_index.push_back(word);
+
+        verse_index.back().word_count++;
+        verse_index.back().frame_count += entry->frames.rows;
+        total_frames += entry->frames.rows;
+    }
+
+    // Per-dimension affine quantization to [-127, 127]
+    std::vector<float> scales(dims, 1.0f), offsets(dims, 0.0f);
+    if (payload_type == PAYLOAD_INT8) {
+        for (int d = 0; d < dims; d++) {
+            double lo = INFINITY, hi = -INFINITY;
+            for (const PendingWord* entry : sorted) {
+                for (int i = 0; i < entry->frames.rows; i++) {
+                    lo = std::min(lo, entry->frames.row(i)[d]);
+                    hi = std::max(hi, entry->frames.row(i)[d]);
+                }
+            }
+            if (lo > hi) continue;
+            offsets[d] = static_cast<float>((lo + hi) / 2.0);
+            scales[d] = hi > lo ? static_cast<float>((hi - lo) / 254.0) : 1.0f;
+        }
+    }
+
+    FeatureStoreHeader header = {};
+    memcpy(header.magic, FEATURE_STORE_MAGIC, 4);
+    header.version = FEATURE_STORE_VERSION;
+    header.payload_type = payload_type;
+    header.dims = dims;
+    header.verse_count = verse_index.size();
+    header.word_count = word_index.size();
+    header.total_frames = total_frames;
+    header.config_hash = config_hash;
+    header.verse_index_offset = alignSection(sizeof(FeatureStoreHeader));
+    header.word_index_offset = alignSection(header.verse_index_offset + verse_index.size() * sizeof(VerseEntry));
+    size_t after_words = alignSection(header.word_index_offset + word_index.size() * sizeof(WordEntry));
+    if (payload_type == PAYLOAD_INT8) {
+        header.quantization_offset = after_words;
+        header.payload_offset = alignSection(after_words + 2 * dims * sizeof(float));
+    } else {
+        header.payload_offset = after_words;
+    }
+
+    size_t frame_bytes = payload_type == PAYLOAD_INT8 ? 1 : sizeof(float);
+    std::vector<uint8_t> bytes(header.payload_offset + (size_t)total_frames * dims * frame_bytes, 0);
+    memcpy(bytes.data(), &header, sizeof(header));
+    if (!verse_index.empty()) {
+        memcpy(bytes.data() + header.verse_index_offset, verse_index.data(), verse_index.size() * sizeof(VerseEntry));
+    }
+    if (!word_index.empty()) {
+        memcpy(bytes.data() + header.word_index_offset, word_index.data(), word_index.size() * sizeof(WordEntry));
+    }
+    if (payload_type == PAYLOAD_INT8) {
+        memcpy(bytes.data() + header.quantization_offset, scales.data(), dims * sizeof(float));
+        memcpy(bytes.data() + header.quantization_offset + dims * sizeof(float), offsets.data(), dims * sizeof(float));
+    }
+
+    uint8_t* payload = bytes.data() + header.payload_offset;
+    for (const PendingWord* entry : sorted) {
+        size_t count = (size_t)entry->frames.rows * dims;
+        for (size_t k = 0; k < count; k++) {
+            double value = entry->frames.data[k];
+            if (payload_type == PAYLOAD_INT8) {
+                int d = k % dims;
+                long q = lround((value - offsets[d]) / scales[d]);
+                *reinterpret_cast<int8_t*>(payload) = static_cast<int8_t>(std::max(-127L, std::min(127L, q)));
+                payload += 1;
+            } else {
+                float f = static_cast<float>(value);
+                memcpy(payload, &f, sizeof(float));
+                payload += sizeof(float);
+            }
+        }
+    }
+
+    return bytes;
+}
+
+bool FeatureStoreWriter::writeFile(const std::string& path, std::string* error) const {
+    std::vector<uint8_t> bytes = serialize();
+
+    // Write to a temporary file and rename, so readers never see a partial store
+    std::string temp_path = path + ".tmp";
+    FILE* file = fopen(temp_path.c_str(), "wb");
+    if (!file) return fail(error, "cannot create feature store file");
+
+    bool written = fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+    written = (fclose(file) == 0) && written;
+    if (!written || rename(temp_path.c_str(), path.c_str()) != 0) {
+        remove(temp_path.c_str());
+        return fail(error, "cannot write feature store file");
+    }
+    return true;
+}
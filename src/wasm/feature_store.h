@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "dtw.h"
+
+// Binary reference feature store
+//
+// Precomputed reference features for the whole mushaf in one file, looked up by
+// (surah, ayah, word). Layout (little-endian, every section 64-byte aligned):
+//
+//   FeatureStoreHeader
+//   VerseEntry[verse_count]      sorted by (surah, ayah)
+//   WordEntry[word_count]        sorted by (surah, ayah, word)
+//   float scale[dims], offset[dims]   only for int8 payloads
+//   payload                      total_frames x dims, float32 or int8
+//
+// A verse's frames are the concatenation of its words' frames, so word
+// boundaries inside a verse are just the word offsets relative to the verse.
+// int8 frames decode as value = q * scale[d] + offset[d].
+
+const char FEATURE_STORE_MAGIC[4] = {'B', 'Q', 'F', 'S'};
+const uint16_t FEATURE_STORE_VERSION = 1;
+
+// Largest frame dimension a store may declare (MFCCs with deltas use 13-39)
+const uint32_t FEATURE_STORE_MAX_DIMS = 4096;
+
+enum FeaturePayloadType : uint16_t {
+    PAYLOAD_FLOAT32 = 0,
+    PAYLOAD_INT8 = 1
+};
+
+struct FeatureStoreHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t payload_type;
+    uint32_t dims;
+    uint32_t verse_count;
+    uint32_t word_count;
+    uint32_t total_frames;
+    uint64_t config_hash;
+    uint64_t verse_index_offset;
+    uint64_t word_index_offset;
+    uint64_t quantization_offset;
+    uint64_t payload_offset;
+};
+
+struct VerseEntry {
+    uint16_t surah;
+    uint16_t ayah;
+    uint32_t first_word;     // index into the word table
+    uint32_t word_count;
+    uint32_t frame_offset;   // first frame in the payload
+    uint32_t frame_count;
+    uint32_t reserved;
+};
+
+struct WordEntry {
+    uint16_t surah;
+    uint16_t ayah;
+    uint16_t word;           // 1-based position in the verse
+    uint16_t reserved;
+    uint32_t frame_offset;
+    uint32_t frame_count;
+};
+
+static_assert(sizeof(FeatureStoreHeader) == 64, "store header layout");
+static_assert(sizeof(VerseEntry) == 24, "verse entry layout");
+static_assert(sizeof(WordEntry) == 16, "word entry layout");
+
+// Read-only view over a store held in memory or mapped from a file
+class FeatureStore {
+private:
+    const uint8_t* base = nullptr;
+    size_t size = 0;
+    const FeatureStoreHeader* header = nullptr;
+    const VerseEntry* verses = nullptr;
+    const WordEntry* words = nullptr;
+    const float* scales = nullptr;
+    const float* offsets = nullptr;
+    std::vector<uint8_t> owned;   // backing memory when the store owns its bytes
+    void* mapping = nullptr;      // native mmap, released in close()
+    size_t mapping_size = 0;
+
+    bool parse(std::string* error);
+
+public:
+    FeatureStore() = default;
+    ~FeatureStore();
+    FeatureStore(const FeatureStore&) = delete;
+    FeatureStore& operator=(const FeatureStore&) = delete;
+
+    // Use bytes that stay owned by the caller and must outlive the store
+    bool open(const uint8_t* data, size_t length, std::string* error = nullptr);
+
+    // Take ownership of a buffer (used by the WASM loader)
+    bool open(std::vector<uint8_t>&& data, std::string* error = nullptr);
+
+#ifndef __EMSCRIPTEN__
+    // Map a store file read-only; pages are loaded on demand
+    bool openFile(const std::string& path, std::string* error = nullptr);
+#endif
+
+    void close();
+
+    bool isOpen() const { return header != nullptr; }
+    int dims() const { return header ? header->dims : 0; }
+    uint64_t configHash() const { return header ? header->config_hash : 0; }
+    FeaturePayloadType payloadType() const { return header ? (FeaturePayloadType)header->payload_type : PAYLOAD_FLOAT32; }
+    uint32_t verseCount() const { return header ? header->verse_count : 0; }
+    uint32_t wordCount() const { return header ? header->word_count : 0; }
+    uint32_t totalFrames() const { return header ? header->total_frames : 0; }
+
+    const VerseEntry* verseAt(uint32_t index) const { return index < verseCount() ? verses + index : nullptr; }
+    const VerseEntry* findVerse(int surah, int ayah) const;
+    const WordEntry* findWord(int surah, int ayah, int word) const;
+    const WordEntry* wordsOf(const VerseEntry& verse) const { return words + verse.first_word; }
+
+    // Raw payload access for kernels that work on the stored representation
+    const float* float32Frames(uint32_t frame_offset) const;
+    const int8_t* int8Frames(uint32_t frame_offset) const;
+    const float* quantizationScales() const { return scales; }
+    const float* quantizationOffsets() const { return offsets; }
+
+    // Decode frames [frame_offset, frame_offset + frame_count) into doubles
+    FeatureMatrix frames(uint32_t frame_offset, uint32_t frame_count) const;
+};
+
+// Accumulates per-word features and serialises them into the store format
+class FeatureStoreWriter {
+private:
+    struct PendingWord {
+        int surah;
+        int ayah;
+        int word;
+        FeatureMatrix frames;
+    };
+
+    int dims;
+    uint64_t config_hash;
+    FeaturePayloadType payload_type;
+    std::vector<PendingWord> pending;
+
+public:
+    FeatureStoreWriter(int dims, uint64_t config_hash, FeaturePayloadType payload_type = PAYLOAD_FLOAT32);
+
+    // Frames must have `dims` coefficients; a repeated key replaces the earlier entry
+    bool addWord(int surah, int ayah, int word, const FeatureMatrix& frames);
+
+    std::vector<uint8_t> serialize() const;
+    bool writeFile(const std::string& path, std::string* error = nullptr) const;
+};
@@ -0,0 +1,121 @@
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "gmm.h"
+
+// Diagonal-covariance GMM emission scoring
+
+// Frames are expanded to [x^2, x] rows in blocks of this many, so a block and
+// all component rows of a typical model stay in L1 while they are scored
+const int GMM_FRAME_BLOCK = 32;
+
+GMMEmissions::GMMEmissions(int states, int components, int feature_dims)
+    : num_states(std::max(0, states)),
+      num_components(std::max(0, components)),
+      num_dims(std::max(0, feature_dims)),
+      row_stride(alignedStride(2 * num_dims)) {
+    coefficients.assign((size_t)num_states * num_components * row_stride, 0.0);
+    constants.assign((size_t)num_states * num_components, LOG_ZERO);
+}
+
+bool GMMEmissions::setComponent(int state, int component, double weight,
+                                const double* means, const double* variances) {
+    if (state < 0 || state >= num_states || component < 0 || component >= num_components) {
+        return false;
+    }
+    
+    const size_t index = (size_t)state * num_components + component;
+    double* row = coefficients.data() + index * row_stride;
+    if (!(weight > 0)) {
+        std::fill(row, row + row_stride, 0.0);
+        constants[index] = LOG_ZERO;
+        return true;
+    }
+    
+    double constant = log(weight) - 0.5 * num_dims * log(2.0 * M_PI);
+    for (int d = 0; d < num_dims; d++) {
+        double variance = std::max(variances[d], 1e-6);
+        double inv_variance = 1.0 / variance;
+        row[d] = -0.5 * inv_variance;
+        row[num_dims + d] = means[d] * inv_variance;
+        constant -= 0.5 * (log(variance) + means[d] * means[d] * inv_variance);
+    }
+    constants[index] = constant;
+    return true;
+}
+
+void GMMEmissions::score(const double* frames, int T, double* out, int out_stride) const {
+    const int D = num_dims;
+    const int K = num_components;
+    thread_local AlignedVector expanded;
+    if (expanded.size() < (size_t)GMM_FRAME_BLOCK * row_stride) {
+        expanded.assign((size_t)GMM_FRAME_BLOCK * row_stride, 0.0);
+    }
+    
+    for (int t0 = 0; t0 < T; t0 += GMM_FRAME_BLOCK) {
+        const int count = std::min(GMM_FRAME_BLOCK, T - t0);
+        
+        for (int f = 0; f < count; f++) {
+            const double* x = frames + (size_t)(t0 + f) * D;
+            double* row = expanded.data() + (size_t)f * row_stride;
+            for (int d = 0; d < D; d++) {
+                row[d] = x[d] * x[d];
+                row[D + d] = x[d];
+            }
+        }
+        
+        for (int f = 0; f < count; f++) {
+            const double* row = expanded.data() + (size_t)f * row_stride;
+            double* dst = out + (size_t)(t0 + f) * out_stride;
+            
+            for (int s = 0; s < num_states; s++) {
+                LogSumExpAccumulator total;
+                for (int k = 0; k < K; k++) {
+                    const size_t index = (size_t)s * K + k;
+                    if (constants[index] == LOG_ZERO) continue;
+                    const double* coefficient = coefficients.data() + index * row_stride;
+                    double dot = 0.0;
+                    for (int d = 0; d < 2 * D; d++) {
+                        dot += row[d] * coefficient[d];
+                    }
+                    total.add(constants[index] + dot);
+                }
+                dst[s] = total.result();
+            }
+        }
+    }
+}
+
+std::vector<double> GMMEmissions::score(const std::vector<double>& frames, int T) const {
+    std::vector<double> scores((size_t)T * num_states, LOG_ZERO);
+    if (T > 0 && frames.size() >= (size_t)T * num_dims) {
+        score(frames.data(), T, scores.data(), num_states);
+    }
+    return scores;
+}
+
+void GMMEmissions::scoreComponents(const double* frame, double* out) const {
+    const int D = num_dims;
+    thread_local AlignedVector row;
+    if (row.size() < (size_t)row_stride) {
+        row.assign(row_stride, 0.0);
+    }
+    for (int d = 0; d < D; d++) {
+        row[d] = frame[d] * frame[d];
+        row[D + d] = frame[d];
+    }
+    
+    const int count = num_states * num_components;
+    for (int index = 0; index < count; index++) {
+        if (constants[index] == LOG_ZERO) {
+            out[index] = LOG_ZERO;
+            continue;
+        }
+        const double* coefficient = coefficients.data() + (size_t)index * row_stride;
+        double dot = 0.0;
+        for (int d = 0; d < 2 * D; d++) {
+            dot += row[d] * coefficient[d];
+        }
+        out[index] = constants[index] + dot;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include "hmm.h"
+
+// Continuous-density emissions for the HMM: one diagonal-covariance Gaussian
+// mixture per state over feature frames (MFCC, optionally with deltas).
+//
+// For a component with weight w, mean mu and variances var,
+//
+//   log N(x) = log w - (D log 2pi + sum_d log var[d]) / 2
+//              - (sum_d x[d]^2 / var[d] - 2 x[d] mu[d] / var[d] + mu[d]^2 / var[d]) / 2
+//
+// The parts that do not depend on x are folded into one constant per component
+// when it is set, together with 1/var and mu/var. Scoring a frame against a
+// component is then one dot product of the frame's [x^2, x] row with the
+// component's [-1/(2 var), mu/var] row, both stored flat and cache-line aligned;
+// score() runs it for a block of frames against all components at once.
+class GMMEmissions {
+private:
+    int num_states;
+    int num_components;         // per state
+    int num_dims;
+    int row_stride;             // padded length of a [x^2, x] / coefficient row
+    AlignedVector coefficients; // (states * components) x row_stride
+    AlignedVector constants;    // per component; LOG_ZERO for unset components
+
+public:
+    GMMEmissions(int states, int components, int feature_dims);
+
+    // Set one mixture component. Variances are floored at 1e-6; a weight of 0
+    // disables the component.
+    bool setComponent(int state, int component, double weight,
+                      const double* means, const double* variances);
+
+    int numStates() const { return num_states; }
+    int numComponents() const { return num_components; }
+    int dims() const { return num_dims; }
+
+    // Log-likelihood of every frame under every state's mixture. frames is
+    // T x dims row-major; out receives T rows of numStates() values, row t at
+    // out + t * out_stride.
+    void score(const double* frames, int T, double* out, int out_stride) const;
+    std::vector<double> score(const std::vector<double>& frames, int T) const;
+
+    // Weighted log-likelihood of one frame under every component: out receives
+    // numStates() x numComponents() values, LOG_ZERO for disabled components.
+    // Used by training, which needs the component posteriors.
+    void scoreComponents(const double* frame, double* out) const;
+};
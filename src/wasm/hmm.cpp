@@ -2,275 +2,595 @@
 #include <cmath>
 #include <algorithm>
 #include <limits>
+#include "hmm.h"
+#include "hmm_decoder.h"
+#include "hmm_registry.h"
+#include "hmm_model_file.h"
+
+#ifdef __EMSCRIPTEN__
 #include <emscripten/bind.h>
+#endif
 
 // Hidden Markov Model for Phoneme Recognition
 // Based on QuranPOC implementation
 
-const double LOG_ZERO = -1e30; // Very small log probability to represent zero
-
 // Log-sum-exp trick for numerical stability
-double log_sum_exp(const std::vector<double>& log_values) {
-    if (log_values.empty()) return LOG_ZERO;
+double log_sum_exp(const double* log_values, int count) {
+    if (count <= 0) return LOG_ZERO;
     
-    double max_val = *std::max_element(log_values.begin(), log_values.end());
+    double max_val = *std::max_element(log_values, log_values + count);
     if (max_val == LOG_ZERO) return LOG_ZERO;
     
     double sum = 0.0;
-    for (double val : log_values) {
-        if (val != LOG_ZERO) {
-            sum += exp(val - max_val);
+    for (int k = 0; k < count; k++) {
+        if (log_values[k] != LOG_ZERO) {
+            sum += exp(log_values[k] - max_val);
         }
     }
     
     return max_val + log(sum);
 }
 
-class HMM {
-private:
-    int num_states;
-    int num_observations;
-    std::vector<std::vector<double>> transition_probs; // log probabilities
-    std::vector<std::vector<double>> emission_probs;   // log probabilities
-    std::vector<double> initial_probs;                 // log probabilities
-    
-public:
-    HMM(int states, int observations) : num_states(states), num_observations(observations) {
-        transition_probs.resize(num_states, std::vector<double>(num_states, LOG_ZERO));
-        emission_probs.resize(num_states, std::vector<double>(num_observations, LOG_ZERO));
-        initial_probs.resize(num_states, LOG_ZERO);
+double log_sum_exp(const std::vector<double>& log_values) {
+    return log_sum_exp(log_values.data(), log_values.size());
+}
+
+HMM::HMM(int states, int observations)
+    : num_states(std::max(0, states)),
+      num_observations(std::max(0, observations)),
+      stride(alignedStride(num_states)) {
+    transitions.assign((size_t)num_states * stride, LOG_ZERO);
+    transitions_in.assign((size_t)num_states * stride, LOG_ZERO);
+    emissions.assign((size_t)num_observations * stride, LOG_ZERO);
+    initial_probs.assign(stride, LOG_ZERO);
+}
+
+void HMM::setTransitionProb(int from_state, int to_state, double prob) {
+    if (prob > 0 && from_state >= 0 && from_state < num_states && to_state >= 0 && to_state < num_states) {
+        transitions[(size_t)from_state * stride + to_state] = log(prob);
+        transitions_in[(size_t)to_state * stride + from_state] = log(prob);
+        topology_current = false;
     }
-    
-    // Set transition probability (converts to log)
-    void setTransitionProb(int from_state, int to_state, double prob) {
-        if (prob > 0 && from_state < num_states && to_state < num_states) {
-            transition_probs[from_state][to_state] = log(prob);
-        }
+}
+
+void HMM::setEmissionProb(int state, int observation, double prob) {
+    if (prob > 0 && state >= 0 && state < num_states && observation >= 0 && observation < num_observations) {
+        emissions[(size_t)observation * stride + state] = log(prob);
     }
-    
-    // Set emission probability (converts to log)
-    void setEmissionProb(int state, int observation, double prob) {
-        if (prob > 0 && state < num_states && observation < num_observations) {
-            emission_probs[state][observation] = log(prob);
+}
+
+void HMM::setInitialProb(int state, double prob) {
+    if (prob > 0 && state >= 0 && state < num_states) {
+        initial_probs[state] = log(prob);
+    }
+}
+
+static double logProbFromFile(float value) {
+    return value <= LOG_ZERO ? LOG_ZERO : value;
+}
+
+void HMM::setLogProbabilities(const float* initial, const float* transitions_from_to, const float* emissions_by_observation) {
+    const int S = num_states;
+    for (int s = 0; s < S; s++) {
+        initial_probs[s] = logProbFromFile(initial[s]);
+        for (int to = 0; to < S; to++) {
+            double value = logProbFromFile(transitions_from_to[(size_t)s * S + to]);
+            transitions[(size_t)s * stride + to] = value;
+            transitions_in[(size_t)to * stride + s] = value;
         }
     }
-    
-    // Set initial probability (converts to log)
-    void setInitialProb(int state, double prob) {
-        if (prob > 0 && state < num_states) {
-            initial_probs[state] = log(prob);
+    for (int o = 0; o < num_observations; o++) {
+        for (int s = 0; s < S; s++) {
+            emissions[(size_t)o * stride + s] = logProbFromFile(emissions_by_observation[(size_t)o * S + s]);
         }
     }
-    
-    // Viterbi algorithm - find most likely sequence of hidden states
-    std::vector<int> viterbi(const std::vector<int>& observations) {
-        int T = observations.size();
-        if (T == 0) return {};
-        
-        // Initialize Viterbi table
-        std::vector<std::vector<double>> viterbi_table(T, std::vector<double>(num_states, LOG_ZERO));
-        std::vector<std::vector<int>> path(T, std::vector<int>(num_states, -1));
-        
-        // Initialize first column
-        for (int s = 0; s < num_states; s++) {
-            if (observations[0] < num_observations) {
-                viterbi_table[0][s] = initial_probs[s] + emission_probs[s][observations[0]];
+    topology_current = false;
+}
+
+// Collect the entries of each row of a row-major S x S log-prob matrix that are not LOG_ZERO
+static void compressRows(const AlignedVector& matrix, int S, int stride, SparseTransitions& sparse) {
+    sparse.offsets.assign(1, 0);
+    sparse.states.clear();
+    sparse.log_probs.clear();
+    for (int r = 0; r < S; r++) {
+        const double* row = matrix.data() + (size_t)r * stride;
+        for (int c = 0; c < S; c++) {
+            if (row[c] != LOG_ZERO) {
+                sparse.states.push_back(c);
+                sparse.log_probs.push_back(row[c]);
             }
         }
-        
-        // Fill the table
-        for (int t = 1; t < T; t++) {
-            if (observations[t] >= num_observations) continue;
-            
-            for (int s = 0; s < num_states; s++) {
-                double max_prob = LOG_ZERO;
-                int best_prev_state = -1;
-                
-                for (int prev_s = 0; prev_s < num_states; prev_s++) {
-                    double prob = viterbi_table[t-1][prev_s] + 
-                                  transition_probs[prev_s][s] + 
-                                  emission_probs[s][observations[t]];
-                    
-                    if (prob > max_prob) {
-                        max_prob = prob;
-                        best_prev_state = prev_s;
-                    }
+        sparse.offsets.push_back(sparse.states.size());
+    }
+}
+
+void HMM::finalizeTopology() {
+    compressRows(transitions_in, num_states, stride, predecessors);
+    compressRows(transitions, num_states, stride, successors);
+    use_sparse = predecessors.states.size() <= SPARSE_TRANSITION_DENSITY * num_states * num_states;
+    topology_current = true;
+}
+
+bool HMM::validObservations(const std::vector<int>& observations) const {
+    for (int observation : observations) {
+        if (observation < 0 || observation >= num_observations) return false;
+    }
+    return true;
+}
+
+// Workspace of the calling thread for the overloads without one
+static HMMWorkspace& threadWorkspace() {
+    thread_local HMMWorkspace workspace;
+    return workspace;
+}
+
+// Grow a workspace column without shrinking it; contents are not preserved
+static void reserveColumn(AlignedVector& column, int size) {
+    if ((int)column.size() < size) column.resize(size);
+}
+
+// One Viterbi column. For each state the best predecessor is a max over one
+// contiguous row of transitions_in, or over its predecessor list for sparse
+// models; the emission is added once per cell outside that loop.
+void HMM::viterbiStep(const double* prev, const double* emission, double* cur, int* back) const {
+    const int S = num_states;
+    if (usesSparseTransitions()) {
+        for (int s = 0; s < S; s++) {
+            double best = LOG_ZERO;
+            int best_prev = 0;
+            for (int k = predecessors.offsets[s]; k < predecessors.offsets[s+1]; k++) {
+                double score = prev[predecessors.states[k]] + predecessors.log_probs[k];
+                if (score > best) {
+                    best = score;
+                    best_prev = predecessors.states[k];
                 }
-                
-                viterbi_table[t][s] = max_prob;
-                path[t][s] = best_prev_state;
             }
+            cur[s] = best == LOG_ZERO ? LOG_ZERO : best + emission[s];
+            back[s] = best_prev;
         }
-        
-        // Backtrack to find the best path
-        std::vector<int> best_path(T);
-        
-        // Find the best final state
-        double max_final_prob = LOG_ZERO;
-        int best_final_state = 0;
-        for (int s = 0; s < num_states; s++) {
-            if (viterbi_table[T-1][s] > max_final_prob) {
-                max_final_prob = viterbi_table[T-1][s];
-                best_final_state = s;
+    } else {
+        for (int s = 0; s < S; s++) {
+            const double* incoming = transitions_in.data() + (size_t)s * stride;
+            double best = prev[0] + incoming[0];
+            int best_prev = 0;
+            for (int p = 1; p < S; p++) {
+                double score = prev[p] + incoming[p];
+                if (score > best) {
+                    best = score;
+                    best_prev = p;
+                }
             }
+            cur[s] = best + emission[s];
+            back[s] = best_prev;
         }
-        
-        // Backtrack
-        best_path[T-1] = best_final_state;
-        for (int t = T-2; t >= 0; t--) {
-            best_path[t] = path[t+1][best_path[t+1]];
-        }
-        
-        return best_path;
     }
+}
+
+// Viterbi over rolling score columns, with backpointers in one flat T x S
+// block. emission_row(t) points at the emission log-likelihoods of all states
+// at frame t.
+template <typename EmissionRows>
+std::vector<int> HMM::viterbiKernel(int T, EmissionRows emission_row, HMMWorkspace& workspace) const {
+    const int S = num_states;
+    reserveColumn(workspace.prev, stride);
+    reserveColumn(workspace.cur, stride);
+    if (workspace.backpointers.size() < (size_t)T * S) workspace.backpointers.resize((size_t)T * S);
+    double* prev = workspace.prev.data();
+    double* cur = workspace.cur.data();
+    int* backpointers = workspace.backpointers.data();
     
-    // Forward algorithm - compute the probability of observations
-    double forward(const std::vector<int>& observations) {
-        int T = observations.size();
-        if (T == 0) return LOG_ZERO;
-        
-        std::vector<std::vector<double>> alpha(T, std::vector<double>(num_states, LOG_ZERO));
-        
-        // Initialize
-        for (int s = 0; s < num_states; s++) {
-            if (observations[0] < num_observations) {
-                alpha[0][s] = initial_probs[s] + emission_probs[s][observations[0]];
-            }
-        }
+    const double* emission = emission_row(0);
+    for (int s = 0; s < S; s++) {
+        prev[s] = initial_probs[s] + emission[s];
+    }
+    
+    for (int t = 1; t < T; t++) {
+        viterbiStep(prev, emission_row(t), cur, backpointers + (size_t)t * S);
+        std::swap(prev, cur);
+    }
+    
+    std::vector<int> best_path(T);
+    best_path[T-1] = std::max_element(prev, prev + S) - prev;
+    for (int t = T-1; t > 0; t--) {
+        best_path[t-1] = backpointers[(size_t)t * S + best_path[t]];
+    }
+    
+    return best_path;
+}
+
+std::vector<int> HMM::viterbi(const std::vector<int>& observations, HMMWorkspace& workspace) const {
+    if (observations.empty() || num_states == 0 || !validObservations(observations)) return {};
+    return viterbiKernel(observations.size(), [&](int t) {
+        return emissions.data() + (size_t)observations[t] * stride;
+    }, workspace);
+}
+
+std::vector<int> HMM::viterbiScores(const double* scores, int T, int score_stride, HMMWorkspace& workspace) const {
+    if (T <= 0 || num_states == 0) return {};
+    return viterbiKernel(T, [&](int t) { return scores + (size_t)t * score_stride; }, workspace);
+}
+
+std::vector<int> HMM::viterbi(const std::vector<int>& observations) const {
+    return viterbi(observations, threadWorkspace());
+}
+
+// Forward pass: alpha[t][s] = logsum_p(alpha[t-1][p] + A[p][s]) + B[s][o_t]. The
+// terms for one state are read from a contiguous row of transitions_in or, for
+// sparse models, from its predecessor list only, and summed as they are formed.
+// Only the previous and current column of alpha are kept.
+template <typename EmissionRows>
+double HMM::forwardKernel(int T, EmissionRows emission_row, HMMWorkspace& workspace) const {
+    const int S = num_states;
+    const bool sparse = usesSparseTransitions();
+    reserveColumn(workspace.prev, stride);
+    reserveColumn(workspace.cur, stride);
+    double* prev = workspace.prev.data();
+    double* cur = workspace.cur.data();
+    
+    const double* emission = emission_row(0);
+    for (int s = 0; s < S; s++) {
+        prev[s] = initial_probs[s] + emission[s];
+    }
+    
+    for (int t = 1; t < T; t++) {
+        emission = emission_row(t);
         
-        // Forward pass
-        for (int t = 1; t < T; t++) {
-            if (observations[t] >= num_observations) continue;
-            
-            for (int s = 0; s < num_states; s++) {
-                std::vector<double> log_probs;
-                
-                for (int prev_s = 0; prev_s < num_states; prev_s++) {
-                    double prob = alpha[t-1][prev_s] + transition_probs[prev_s][s];
-                    log_probs.push_back(prob);
+        for (int s = 0; s < S; s++) {
+            LogSumExpAccumulator total;
+            if (sparse) {
+                for (int k = predecessors.offsets[s]; k < predecessors.offsets[s+1]; k++) {
+                    total.add(prev[predecessors.states[k]] + predecessors.log_probs[k]);
+                }
+            } else {
+                const double* incoming = transitions_in.data() + (size_t)s * stride;
+                for (int p = 0; p < S; p++) {
+                    total.add(prev[p] + incoming[p]);
                 }
-                
-                alpha[t][s] = log_sum_exp(log_probs) + emission_probs[s][observations[t]];
             }
+            double sum = total.result();
+            cur[s] = sum == LOG_ZERO ? LOG_ZERO : sum + emission[s];
         }
-        
-        // Sum final probabilities
-        std::vector<double> final_probs;
-        for (int s = 0; s < num_states; s++) {
-            final_probs.push_back(alpha[T-1][s]);
-        }
-        
-        return log_sum_exp(final_probs);
+        std::swap(prev, cur);
     }
     
-    // Backward algorithm
-    double backward(const std::vector<int>& observations) {
-        int T = observations.size();
-        if (T == 0) return LOG_ZERO;
-        
-        std::vector<std::vector<double>> beta(T, std::vector<double>(num_states, LOG_ZERO));
-        
-        // Initialize - all final states have probability 1 (log(1) = 0)
-        for (int s = 0; s < num_states; s++) {
-            beta[T-1][s] = 0.0;
+    LogSumExpAccumulator total;
+    for (int s = 0; s < S; s++) {
+        total.add(prev[s]);
+    }
+    return total.result();
+}
+
+double HMM::forward(const std::vector<int>& observations, HMMWorkspace& workspace) const {
+    if (observations.empty() || num_states == 0 || !validObservations(observations)) return LOG_ZERO;
+    return forwardKernel(observations.size(), [&](int t) {
+        return emissions.data() + (size_t)observations[t] * stride;
+    }, workspace);
+}
+
+double HMM::forwardScores(const double* scores, int T, int score_stride, HMMWorkspace& workspace) const {
+    if (T <= 0 || num_states == 0) return LOG_ZERO;
+    return forwardKernel(T, [&](int t) { return scores + (size_t)t * score_stride; }, workspace);
+}
+
+double HMM::forward(const std::vector<int>& observations) const {
+    return forward(observations, threadWorkspace());
+}
+
+// Backward pass: beta[t][s] = logsum_n(A[s][n] + B[n][o_t+1] + beta[t+1][n]). The
+// last two terms do not depend on s, so they are summed once per frame and each
+// state reads its own row of transitions (its successor list if sparse). Only
+// two columns of beta are kept.
+double HMM::backward(const std::vector<int>& observations, HMMWorkspace& workspace) const {
+    const int T = observations.size();
+    const int S = num_states;
+    if (T == 0 || S == 0 || !validObservations(observations)) return LOG_ZERO;
+    
+    const bool sparse = usesSparseTransitions();
+    reserveColumn(workspace.prev, stride);
+    reserveColumn(workspace.cur, stride);
+    reserveColumn(workspace.terms, stride);
+    double* next = workspace.prev.data();
+    double* cur = workspace.cur.data();
+    double* next_terms = workspace.terms.data();
+    
+    // All final states have probability 1 (log(1) = 0)
+    std::fill(next, next + S, 0.0);
+    
+    for (int t = T-2; t >= 0; t--) {
+        const double* emission = emissions.data() + (size_t)observations[t+1] * stride;
+        for (int n = 0; n < S; n++) {
+            next_terms[n] = emission[n] + next[n];
         }
         
-        // Backward pass
-        for (int t = T-2; t >= 0; t--) {
-            if (observations[t+1] >= num_observations) continue;
-            
-            for (int s = 0; s < num_states; s++) {
-                std::vector<double> log_probs;
-                
-                for (int next_s = 0; next_s < num_states; next_s++) {
-                    double prob = transition_probs[s][next_s] + 
-                                  emission_probs[next_s][observations[t+1]] + 
-                                  beta[t+1][next_s];
-                    log_probs.push_back(prob);
+        for (int s = 0; s < S; s++) {
+            LogSumExpAccumulator total;
+            if (sparse) {
+                for (int k = successors.offsets[s]; k < successors.offsets[s+1]; k++) {
+                    total.add(successors.log_probs[k] + next_terms[successors.states[k]]);
+                }
+            } else {
+                const double* outgoing = transitions.data() + (size_t)s * stride;
+                for (int n = 0; n < S; n++) {
+                    total.add(outgoing[n] + next_terms[n]);
                 }
-                
-                beta[t][s] = log_sum_exp(log_probs);
-            }
-        }
-        
-        // Compute initial probability
-        std::vector<double> initial_backward_probs;
-        for (int s = 0; s < num_states; s++) {
-            if (observations[0] < num_observations) {
-                double prob = initial_probs[s] + 
-                              emission_probs[s][observations[0]] + 
-                              beta[0][s];
-                initial_backward_probs.push_back(prob);
             }
+            cur[s] = total.result();
         }
-        
-        return log_sum_exp(initial_backward_probs);
+        std::swap(next, cur);
     }
-};
+    
+    const double* emission = emissions.data() + (size_t)observations[0] * stride;
+    LogSumExpAccumulator total;
+    for (int s = 0; s < S; s++) {
+        total.add(initial_probs[s] + emission[s] + next[s]);
+    }
+    return total.result();
+}
+
+double HMM::backward(const std::vector<int>& observations) const {
+    return backward(observations, threadWorkspace());
+}
+
+#ifdef __EMSCRIPTEN__
 
-// Global HMM instance for JavaScript interface
-static HMM* global_hmm = nullptr;
+// Models loaded from JavaScript, by handle. Every function below takes the
+// handle returned by createHMM; set* calls fail once the model has been used
+// for decoding.
+static HMMRegistry hmm_models;
+
+static const double NEG_INFINITY = -std::numeric_limits<double>::infinity();
 
 // JavaScript interface functions
-void createHMM(int num_states, int num_observations) {
-    if (global_hmm) {
-        delete global_hmm;
+int createHMM(int num_states, int num_observations) {
+    return hmm_models.create(num_states, num_observations);
+}
+
+bool setTransition(int handle, int from_state, int to_state, double prob) {
+    HMMModel* model = hmm_models.edit(handle);
+    if (!model) {
+        return false;
+    }
+    model->hmm.setTransitionProb(from_state, to_state, prob);
+    return true;
+}
+
+bool setEmission(int handle, int state, int observation, double prob) {
+    HMMModel* model = hmm_models.edit(handle);
+    if (!model) {
+        return false;
     }
-    global_hmm = new HMM(num_states, num_observations);
+    model->hmm.setEmissionProb(state, observation, prob);
+    return true;
 }
 
-void setTransition(int from_state, int to_state, double prob) {
-    if (global_hmm) {
-        global_hmm->setTransitionProb(from_state, to_state, prob);
+bool setInitial(int handle, int state, double prob) {
+    HMMModel* model = hmm_models.edit(handle);
+    if (!model) {
+        return false;
     }
+    model->hmm.setInitialProb(state, prob);
+    return true;
 }
 
-void setEmission(int state, int observation, double prob) {
-    if (global_hmm) {
-        global_hmm->setEmissionProb(state, observation, prob);
+// Error message of the last failed load
+static std::string hmm_model_error;
+
+static int installModel(std::unique_ptr<HMMModel> model, const std::string& error) {
+    if (!model) {
+        hmm_model_error = error;
+        return -1;
     }
+    return hmm_models.add(std::move(*model));
+}
+
+// Load a binary model file (hmm_model_file.h) given as a Uint8Array. Returns
+// the model's handle, or -1 (see hmmModelError).
+int loadHMMModel(const emscripten::val& bytes_js) {
+    std::vector<uint8_t> bytes = emscripten::convertJSArrayToNumberVector<uint8_t>(bytes_js);
+    std::string error;
+    auto model = parseHMMModel(bytes.data(), bytes.size(), &error);
+    return installModel(std::move(model), error);
+}
+
+// Discrete model from one Float32Array of log probabilities: initial[S],
+// transitions[S][S] as [from][to], emissions[O][S] as [obs][state]
+int createHMMFromLogProbs(int num_states, int num_observations, const emscripten::val& values_js) {
+    std::vector<float> values = emscripten::convertJSArrayToNumberVector<float>(values_js);
+    std::string error;
+    auto model = modelFromLogProbs(num_states, num_observations, values.data(), values.size(), &error);
+    return installModel(std::move(model), error);
 }
 
-void setInitial(int state, double prob) {
-    if (global_hmm) {
-        global_hmm->setInitialProb(state, prob);
+std::string hmmModelError() {
+    return hmm_model_error;
+}
+
+// { states, observations, components, dims } of a model, or null. Like any
+// use, this seals the model.
+emscripten::val hmmModelInfo(int handle) {
+    auto model = hmm_models.get(handle);
+    if (!model) {
+        return emscripten::val::null();
     }
+    emscripten::val info = emscripten::val::object();
+    info.set("states", model->hmm.numStates());
+    info.set("observations", model->hmm.numObservations());
+    info.set("components", model->emissions ? model->emissions->numComponents() : 0);
+    info.set("dims", model->emissions ? model->emissions->dims() : 0);
+    return info;
 }
 
-emscripten::val viterbi(const emscripten::val& observations_js) {
-    if (!global_hmm) {
+emscripten::val viterbi(int handle, const emscripten::val& observations_js) {
+    auto model = hmm_models.get(handle);
+    if (!model) {
         return emscripten::val::array();
     }
     
     std::vector<int> observations = emscripten::vecFromJSArray<int>(observations_js);
-    auto result = global_hmm->viterbi(observations);
+    auto result = model->kernels->viterbi(observations, threadWorkspace());
     
     return emscripten::val::array(result.begin(), result.end());
 }
 
-double forward(const emscripten::val& observations_js) {
-    if (!global_hmm) {
-        return -std::numeric_limits<double>::infinity();
+// Beam-pruned Viterbi for large models; beam is in log probability below the
+// best token and max_active caps the tokens kept per frame
+emscripten::val viterbiBeam(int handle, const emscripten::val& observations_js, double beam, int max_active) {
+    auto model = hmm_models.get(handle);
+    if (!model) {
+        return emscripten::val::array();
     }
     
+    BeamOptions options;
+    options.beam = beam;
+    options.max_active = max_active;
+    BeamViterbiDecoder decoder(model->hmm, options);
     std::vector<int> observations = emscripten::vecFromJSArray<int>(observations_js);
-    return global_hmm->forward(observations);
+    auto result = decoder.decode(observations);
+    
+    return emscripten::val::array(result.begin(), result.end());
 }
 
-double backward(const emscripten::val& observations_js) {
-    if (!global_hmm) {
-        return -std::numeric_limits<double>::infinity();
+double forward(int handle, const emscripten::val& observations_js) {
+    auto model = hmm_models.get(handle);
+    if (!model) {
+        return NEG_INFINITY;
     }
     
     std::vector<int> observations = emscripten::vecFromJSArray<int>(observations_js);
-    return global_hmm->backward(observations);
+    return model->kernels->forward(observations, threadWorkspace());
 }
 
-void cleanupHMM() {
-    if (global_hmm) {
-        delete global_hmm;
-        global_hmm = nullptr;
+double backward(int handle, const emscripten::val& observations_js) {
+    auto model = hmm_models.get(handle);
+    if (!model) {
+        return NEG_INFINITY;
+    }
+    
+    std::vector<int> observations = emscripten::vecFromJSArray<int>(observations_js);
+    return model->hmm.backward(observations);
+}
+
+// Diagonal-covariance mixture emissions with `components` Gaussians per state
+// over `dims`-dimensional frames (e.g. 13 MFCCs, or 26 with deltas), used by
+// the *Features functions and streamed feature frames
+bool createGMMEmissions(int handle, int num_components, int dims) {
+    HMMModel* model = hmm_models.edit(handle);
+    if (!model) {
+        return false;
+    }
+    model->emissions.reset(new GMMEmissions(model->hmm.numStates(), num_components, dims));
+    return true;
+}
+
+bool setGMMComponent(int handle, int state, int component, double weight,
+                     const emscripten::val& means_js, const emscripten::val& variances_js) {
+    HMMModel* model = hmm_models.edit(handle);
+    if (!model || !model->emissions) {
+        return false;
+    }
+    GMMEmissions& gmm = *model->emissions;
+    std::vector<double> means = emscripten::convertJSArrayToNumberVector<double>(means_js);
+    std::vector<double> variances = emscripten::convertJSArrayToNumberVector<double>(variances_js);
+    if ((int)means.size() != gmm.dims() || (int)variances.size() != gmm.dims()) {
+        return false;
     }
+    return gmm.setComponent(state, component, weight, means.data(), variances.data());
+}
+
+// Score a flat Float64Array of frames (frames x dims) against the mixtures;
+// empty if the model has none or the frames do not fit
+static std::vector<double> scoreFeatures(const HMMModel& model, const emscripten::val& frames_js, int frames) {
+    if (!model.emissions || frames <= 0) {
+        return {};
+    }
+    std::vector<double> data = emscripten::convertJSArrayToNumberVector<double>(frames_js);
+    if (data.size() != (size_t)frames * model.emissions->dims()) {
+        return {};
+    }
+    return model.emissions->score(data, frames);
+}
+
+emscripten::val viterbiFeatures(int handle, const emscripten::val& frames_js, int frames) {
+    auto model = hmm_models.get(handle);
+    std::vector<double> scores = model ? scoreFeatures(*model, frames_js, frames) : std::vector<double>();
+    if (scores.empty()) {
+        return emscripten::val::array();
+    }
+    auto result = model->kernels->viterbiScores(scores.data(), frames, model->hmm.numStates(), threadWorkspace());
+    return emscripten::val::array(result.begin(), result.end());
+}
+
+double forwardFeatures(int handle, const emscripten::val& frames_js, int frames) {
+    auto model = hmm_models.get(handle);
+    std::vector<double> scores = model ? scoreFeatures(*model, frames_js, frames) : std::vector<double>();
+    if (scores.empty()) {
+        return NEG_INFINITY;
+    }
+    return model->kernels->forwardScores(scores.data(), frames, model->hmm.numStates(), threadWorkspace());
+}
+
+// A streaming decoder holding on to its model; with an unknown handle every
+// push returns nothing
+struct StreamingSession {
+    std::shared_ptr<const HMMModel> model;
+    StreamingViterbi decoder;
+
+    explicit StreamingSession(std::shared_ptr<const HMMModel> shared, int lag)
+        : model(std::move(shared)), decoder(model->hmm, lag) {}
+};
+
+StreamingSession* createStreamingSession(int handle, int lag) {
+    auto model = hmm_models.get(handle);
+    if (!model) {
+        model = std::make_shared<const HMMModel>(0, 0);
+    }
+    return new StreamingSession(model, lag);
+}
+
+static emscripten::val statesToJS(const std::vector<int>& states) {
+    return emscripten::val::array(states.begin(), states.end());
+}
+
+// The committed states, or null if the observation is out of range and was
+// not decoded
+emscripten::val streamingPushObservation(StreamingSession& session, int observation) {
+    const std::vector<int>* states = session.decoder.pushObservation(observation);
+    return states ? statesToJS(*states) : emscripten::val::null();
+}
+
+// One feature frame scored with the model's GMM emissions; null if the model
+// has none or the frame has the wrong dimension
+emscripten::val streamingPushFeatures(StreamingSession& session, const emscripten::val& frame_js) {
+    std::vector<double> scores = scoreFeatures(*session.model, frame_js, 1);
+    if (scores.empty()) {
+        return emscripten::val::null();
+    }
+    return statesToJS(session.decoder.pushScores(scores.data()));
+}
+
+emscripten::val streamingFinish(StreamingSession& session) {
+    return statesToJS(session.decoder.finish());
+}
+
+void streamingReset(StreamingSession& session) {
+    session.decoder.reset();
+}
+
+int streamingCommittedCount(const StreamingSession& session) {
+    return session.decoder.committedCount();
+}
+
+int streamingBestState(const StreamingSession& session) {
+    return session.decoder.bestState();
+}
+
+// Decodes already running keep their model until they return
+bool releaseHMM(int handle) {
+    return hmm_models.release(handle);
+}
+
+void cleanupHMM() {
+    hmm_models.clear();
 }
 
 // Emscripten bindings
@@ -279,11 +599,32 @@ EMSCRIPTEN_BINDINGS(hmm_processor) {
     emscripten::function("setTransition", &setTransition);
     emscripten::function("setEmission", &setEmission);
     emscripten::function("setInitial", &setInitial);
+    emscripten::function("loadHMMModel", &loadHMMModel);
+    emscripten::function("createHMMFromLogProbs", &createHMMFromLogProbs);
+    emscripten::function("hmmModelError", &hmmModelError);
+    emscripten::function("hmmModelInfo", &hmmModelInfo);
     emscripten::function("viterbi", &viterbi);
+    emscripten::function("viterbiBeam", &viterbiBeam);
     emscripten::function("forward", &forward);
     emscripten::function("backward", &backward);
+    emscripten::function("createGMMEmissions", &createGMMEmissions);
+    emscripten::function("setGMMComponent", &setGMMComponent);
+    emscripten::function("viterbiFeatures", &viterbiFeatures);
+    emscripten::function("forwardFeatures", &forwardFeatures);
+    emscripten::function("releaseHMM", &releaseHMM);
     emscripten::function("cleanupHMM", &cleanupHMM);
     
+    emscripten::class_<StreamingSession>("StreamingViterbi")
+        .constructor(&createStreamingSession, emscripten::allow_raw_pointers())
+        .function("pushObservation", &streamingPushObservation)
+        .function("pushFeatures", &streamingPushFeatures)
+        .function("finish", &streamingFinish)
+        .function("reset", &streamingReset)
+        .function("committedCount", &streamingCommittedCount)
+        .function("bestState", &streamingBestState);
+    
     emscripten::register_vector<int>("VectorInt");
     emscripten::register_vector<double>("VectorDouble");
-}
\ No newline at end of file
+}
+
+#endif // __EMSCRIPTEN__
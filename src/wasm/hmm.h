@@ -0,0 +1,187 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <new>
+
+// Hidden Markov Model for Phoneme Recognition
+// Shared by the WebAssembly module (hmm.cpp bindings) and native tools.
+
+const double LOG_ZERO = -1e30; // Very small log probability to represent zero
+
+// Log-sum-exp trick for numerical stability
+double log_sum_exp(const double* log_values, int count);
+double log_sum_exp(const std::vector<double>& log_values);
+
+// Single-pass log-sum-exp: keeps the running maximum and the sum of exp(v - max),
+// rescaling the sum when a larger value arrives. Terms are added as they are
+// computed, so no buffer of them is needed. LOG_ZERO terms are skipped.
+struct LogSumExpAccumulator {
+    double max_value = LOG_ZERO;
+    double sum = 0.0;
+
+    void add(double value) {
+        if (value == LOG_ZERO) return;
+        if (value <= max_value) {
+            sum += std::exp(value - max_value);
+        } else {
+            sum = sum * std::exp(max_value - value) + 1.0;
+            max_value = value;
+        }
+    }
+
+    double result() const { return max_value == LOG_ZERO ? LOG_ZERO : max_value + std::log(sum); }
+};
+
+// Parameter rows start on 64-byte (cache line) boundaries so the inner loops
+// of the kernels read whole lines and vectorise without peeling
+const size_t HMM_ALIGNMENT = 64;
+
+template <typename T>
+struct AlignedAllocator {
+    typedef T value_type;
+
+    AlignedAllocator() = default;
+    template <typename U> AlignedAllocator(const AlignedAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(HMM_ALIGNMENT)));
+    }
+    void deallocate(T* p, size_t) {
+        ::operator delete(p, std::align_val_t(HMM_ALIGNMENT));
+    }
+
+    template <typename U> bool operator==(const AlignedAllocator<U>&) const { return true; }
+    template <typename U> bool operator!=(const AlignedAllocator<U>&) const { return false; }
+};
+
+typedef std::vector<double, AlignedAllocator<double>> AlignedVector;
+
+// Row length in doubles rounded up to whole cache lines
+inline int alignedStride(int count) {
+    const int per_line = HMM_ALIGNMENT / sizeof(double);
+    return (count + per_line - 1) / per_line * per_line;
+}
+
+// Scratch buffers for the kernels, kept apart from the model so one model can be
+// used from several threads. Buffers grow to the largest model and sequence seen
+// and are reused, so repeated calls do not allocate. The kernel overloads
+// without a workspace use one thread_local workspace per thread.
+struct HMMWorkspace {
+    AlignedVector prev;                 // rolling score columns
+    AlignedVector cur;
+    AlignedVector terms;                // per-frame emission + beta for backward
+    std::vector<int> backpointers;      // Viterbi, T x S
+};
+
+// Nonzero transitions in compressed rows (CSR): row r lists its (state, log
+// prob) pairs in increasing state order in [offsets[r], offsets[r+1])
+struct SparseTransitions {
+    std::vector<int> offsets;
+    std::vector<int> states;
+    std::vector<double> log_probs;
+};
+
+// Models with at most this fraction of nonzero transitions use the sparse
+// kernels; denser ones stay on the contiguous dense rows, which vectorise
+const double SPARSE_TRANSITION_DENSITY = 0.25;
+
+// Discrete-observation HMM with all parameters as log probabilities in flat,
+// row-major, cache-line aligned matrices (rows padded to `stride` entries):
+//
+//   transitions      S x S   [from][to]   backward reads a source state's row
+//   transitions_in   S x S   [to][from]   transposed copy: Viterbi and forward
+//                                          read all predecessors of a state
+//   emissions        O x S   [obs][state]  one frame's emissions are one row
+//
+// Both transition layouts are kept in sync by setTransitionProb.
+//
+// Left-to-right (Bakis) models have only a few nonzero transitions per state.
+// finalizeTopology() collects them into predecessor lists (CSR by destination,
+// for Viterbi and forward) and successor lists (CSR by source, for backward),
+// so those kernels run in O(T * S * k) for k transitions per state instead of
+// O(T * S^2). Until it is called after the last setTransitionProb the dense
+// kernels are used.
+class HMM {
+private:
+    int num_states;
+    int num_observations;
+    int stride;                     // padded row length for state-indexed rows
+    AlignedVector transitions;
+    AlignedVector transitions_in;
+    AlignedVector emissions;
+    AlignedVector initial_probs;
+
+    SparseTransitions predecessors;   // row = destination state
+    SparseTransitions successors;     // row = source state
+    bool topology_current = false;    // lists match the transition matrix
+    bool use_sparse = false;
+
+    // Kernels shared by discrete observations and precomputed emission scores
+    template <typename EmissionRows>
+    std::vector<int> viterbiKernel(int T, EmissionRows emission_row, HMMWorkspace& workspace) const;
+    template <typename EmissionRows>
+    double forwardKernel(int T, EmissionRows emission_row, HMMWorkspace& workspace) const;
+
+public:
+    HMM(int states, int observations);
+
+    // Set transition probability (converts to log)
+    void setTransitionProb(int from_state, int to_state, double prob);
+
+    // Set emission probability (converts to log)
+    void setEmissionProb(int state, int observation, double prob);
+
+    // Set initial probability (converts to log)
+    void setInitialProb(int state, double prob);
+
+    // Install every parameter at once from log probabilities, as stored in a
+    // model file: initial[S], transitions[S][S] as [from][to] and
+    // emissions[O][S] as [obs][state]. Values <= LOG_ZERO (e.g. -inf) are
+    // impossible events. No log() per entry, so loading large models is a copy.
+    void setLogProbabilities(const float* initial, const float* transitions_from_to, const float* emissions_by_observation);
+
+    // Rebuild the sparse transition lists and choose dense or sparse kernels
+    void finalizeTopology();
+    bool topologyCurrent() const { return topology_current; }
+    bool usesSparseTransitions() const { return topology_current && use_sparse; }
+
+    int numStates() const { return num_states; }
+    int numObservations() const { return num_observations; }
+
+    // Every observation in [0, numObservations())
+    bool validObservations(const std::vector<int>& observations) const;
+
+    // Successor lists as of the last finalizeTopology(); decoders walk these
+    const SparseTransitions& successorLists() const { return successors; }
+    const double* emissionRow(int observation) const { return emissions.data() + (size_t)observation * stride; }
+
+    double transitionLogProb(int from_state, int to_state) const { return transitions[(size_t)from_state * stride + to_state]; }
+    double emissionLogProb(int state, int observation) const { return emissions[(size_t)observation * stride + state]; }
+    double initialLogProb(int state) const { return initial_probs[state]; }
+
+    // One step of the Viterbi recursion: cur[s] = max over p of prev[p] plus the
+    // transition p -> s, plus emission[s]; back[s] = that best p
+    void viterbiStep(const double* prev, const double* emission, double* cur, int* back) const;
+
+    // Viterbi algorithm - most likely sequence of hidden states. Empty if an
+    // observation is outside [0, numObservations()).
+    std::vector<int> viterbi(const std::vector<int>& observations, HMMWorkspace& workspace) const;
+    std::vector<int> viterbi(const std::vector<int>& observations) const;
+
+    // Forward algorithm - log probability of the observations (LOG_ZERO if an
+    // observation is out of range). Only two columns of alpha are kept.
+    double forward(const std::vector<int>& observations, HMMWorkspace& workspace) const;
+    double forward(const std::vector<int>& observations) const;
+
+    // Continuous emissions: Viterbi and forward on a precomputed T x numStates()
+    // matrix of emission log-likelihoods, row t at scores + t * score_stride
+    // (e.g. from GMMEmissions::score). The discrete emissions are not used.
+    std::vector<int> viterbiScores(const double* scores, int T, int score_stride, HMMWorkspace& workspace) const;
+    double forwardScores(const double* scores, int T, int score_stride, HMMWorkspace& workspace) const;
+
+    // Backward algorithm - same quantity computed from the end
+    double backward(const std::vector<int>& observations, HMMWorkspace& workspace) const;
+    double backward(const std::vector<int>& observations) const;
+};
@@ -0,0 +1,274 @@
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include "hmm_decoder.h"
+
+// Beam-pruned token-passing Viterbi decoder
+
+// Score histogram resolution for max-active pruning
+const int PRUNE_HISTOGRAM_BINS = 64;
+
+BeamViterbiDecoder::BeamViterbiDecoder(const HMM& model, const BeamOptions& decoder_options)
+    : hmm(model), options(decoder_options) {
+    options.max_active = std::max(1, options.max_active);
+}
+
+void BeamViterbiDecoder::prune(std::vector<Token>& tokens) {
+    if (tokens.empty()) return;
+
+    double best = LOG_ZERO, worst = std::numeric_limits<double>::infinity();
+    for (const Token& token : tokens) {
+        best = std::max(best, token.score);
+        worst = std::min(worst, token.score);
+    }
+    const double threshold = best - options.beam;
+
+    int within_beam = 0;
+    for (const Token& token : tokens) {
+        if (token.score >= threshold) within_beam++;
+    }
+
+    if (within_beam <= options.max_active) {
+        if (within_beam < (int)tokens.size()) {
+            tokens.erase(std::remove_if(tokens.begin(), tokens.end(),
+                                        [&](const Token& token) { return token.score < threshold; }),
+                         tokens.end());
+        }
+        return;
+    }
+
+    // Too many within the beam: bin the distances below the best score and keep
+    // whole bins from the top until max_active tokens are covered
+    const double range = best - std::max(threshold, worst);
+    if (!(range > 0)) return;
+    const double width = range / PRUNE_HISTOGRAM_BINS;
+    auto binOf = [&](double score) {
+        return std::min(PRUNE_HISTOGRAM_BINS - 1, (int)((best - score) / width));
+    };
+
+    histogram.assign(PRUNE_HISTOGRAM_BINS, 0);
+    for (const Token& token : tokens) {
+        if (token.score >= threshold) histogram[binOf(token.score)]++;
+    }
+    int last_bin = 0;
+    for (int covered = histogram[0]; covered < options.max_active && last_bin + 1 < PRUNE_HISTOGRAM_BINS; ) {
+        covered += histogram[++last_bin];
+    }
+
+    tokens.erase(std::remove_if(tokens.begin(), tokens.end(), [&](const Token& token) {
+                     return token.score < threshold || binOf(token.score) > last_bin;
+                 }),
+                 tokens.end());
+}
+
+// emission_row(t) points at the emission log-likelihoods of all states at frame t
+template <typename EmissionRows>
+std::vector<int> BeamViterbiDecoder::run(int T, EmissionRows emission_row) {
+    const int S = hmm.numStates();
+    const SparseTransitions& successors = hmm.successorLists();
+    final_score = LOG_ZERO;
+    expanded_tokens = 0;
+    frames = T;
+
+    active.clear();
+    arena.clear();
+    next_score.assign(S, LOG_ZERO);
+    next_previous.assign(S, -1);
+    next_slot.assign(S, -1);
+
+    const double* emission = emission_row(0);
+    for (int s = 0; s < S; s++) {
+        if (hmm.initialLogProb(s) == LOG_ZERO) continue;
+        active.push_back({s, hmm.initialLogProb(s) + emission[s], -1});
+    }
+    prune(active);
+    for (Token& token : active) {
+        token.arena_index = arena.size();
+        arena.push_back({token.state, -1});
+    }
+
+    for (int t = 1; t < T && !active.empty(); t++) {
+        expanded_tokens += active.size();
+        emission = emission_row(t);
+        next_active.clear();
+
+        // Pass every token along its outgoing arcs, keeping the best arrival per
+        // state; ties go to the lower predecessor state, as in HMM::viterbi
+        for (const Token& token : active) {
+            for (int k = successors.offsets[token.state]; k < successors.offsets[token.state + 1]; k++) {
+                const int to = successors.states[k];
+                const double score = token.score + successors.log_probs[k];
+                if (next_slot[to] < 0) {
+                    next_slot[to] = next_active.size();
+                    next_active.push_back({to, 0.0, -1});
+                } else if (score < next_score[to] ||
+                           (score == next_score[to] && token.state > arena[next_previous[to]].state)) {
+                    continue;
+                }
+                next_score[to] = score;
+                next_previous[to] = token.arena_index;
+            }
+        }
+
+        for (Token& token : next_active) {
+            token.score = next_score[token.state] + emission[token.state];
+            token.arena_index = next_previous[token.state];
+            next_slot[token.state] = -1;
+        }
+        prune(next_active);
+        for (Token& token : next_active) {
+            const int previous = token.arena_index;
+            token.arena_index = arena.size();
+            arena.push_back({token.state, previous});
+        }
+        std::swap(active, next_active);
+    }
+    expanded_tokens += active.size();
+
+    if (active.empty()) return {};
+
+    const Token* best = &active[0];
+    for (const Token& token : active) {
+        if (token.score > best->score || (token.score == best->score && token.state < best->state)) {
+            best = &token;
+        }
+    }
+    final_score = best->score;
+
+    std::vector<int> path(T);
+    int index = best->arena_index;
+    for (int t = T-1; t >= 0; t--) {
+        path[t] = arena[index].state;
+        index = arena[index].previous;
+    }
+    return path;
+}
+
+std::vector<int> BeamViterbiDecoder::decode(const std::vector<int>& observations) {
+    if (observations.empty() || !hmm.topologyCurrent() || !hmm.validObservations(observations)) return {};
+    return run(observations.size(), [&](int t) { return hmm.emissionRow(observations[t]); });
+}
+
+std::vector<int> BeamViterbiDecoder::decodeScores(const double* scores, int T, int score_stride) {
+    if (T <= 0 || !hmm.topologyCurrent()) return {};
+    return run(T, [&](int t) { return scores + (size_t)t * score_stride; });
+}
+
+StreamingViterbi::StreamingViterbi(const HMM& model, int max_lag)
+    : hmm(model), lag(std::max(0, max_lag)) {
+    const int S = hmm.numStates();
+    scores.resize(alignedStride(S));
+    next_scores.resize(alignedStride(S));
+    backpointers.resize((size_t)(lag + 1) * S);
+    frontier.reserve(S);
+    next_frontier.reserve(S);
+    stamps.assign(S, 0);
+    reset();
+}
+
+void StreamingViterbi::reset() {
+    frames = 0;
+    committed = 0;
+    committed_states.clear();
+}
+
+int StreamingViterbi::bestState() const {
+    const int S = hmm.numStates();
+    if (frames == 0 || S == 0) return -1;
+    return std::max_element(scores.begin(), scores.begin() + S) - scores.begin();
+}
+
+double StreamingViterbi::bestScore() const {
+    int state = bestState();
+    return state < 0 ? LOG_ZERO : scores[state];
+}
+
+// Latest frame at which the survivor paths of all reachable states pass
+// through one state, or -1 if they do not merge among the uncommitted frames
+int StreamingViterbi::convergencePoint(int& state) {
+    const int S = hmm.numStates();
+    frontier.clear();
+    for (int s = 0; s < S; s++) {
+        if (scores[s] > LOG_ZERO) frontier.push_back(s);
+    }
+    int frame = frames - 1;
+    while (frontier.size() > 1 && frame > committed) {
+        const int* back = backpointerColumn(frame);
+        stamp++;
+        next_frontier.clear();
+        for (int s : frontier) {
+            int previous = back[s];
+            if (stamps[previous] != stamp) {
+                stamps[previous] = stamp;
+                next_frontier.push_back(previous);
+            }
+        }
+        std::swap(frontier, next_frontier);
+        frame--;
+    }
+    if (frontier.size() != 1) return -1;
+    state = frontier[0];
+    return frame;
+}
+
+// Append frames [committed, frame] of the path through `state` at `frame`
+void StreamingViterbi::commitThrough(int frame, int state) {
+    const size_t first = committed_states.size();
+    committed_states.resize(first + frame - committed + 1);
+    for (int t = frame; t >= committed; t--) {
+        committed_states[first + t - committed] = state;
+        if (t > committed) state = backpointerColumn(t)[state];
+    }
+    committed = frame + 1;
+}
+
+const std::vector<int>& StreamingViterbi::push(const double* emission) {
+    const int S = hmm.numStates();
+    committed_states.clear();
+    if (S == 0) return committed_states;
+
+    if (frames == 0) {
+        for (int s = 0; s < S; s++) {
+            scores[s] = hmm.initialLogProb(s) + emission[s];
+        }
+    } else {
+        int* back = backpointers.data() + (size_t)(frames % (lag + 1)) * S;
+        hmm.viterbiStep(scores.data(), emission, next_scores.data(), back);
+        std::swap(scores, next_scores);
+    }
+    frames++;
+
+    int state;
+    int frame = convergencePoint(state);
+    if (frame >= committed) {
+        commitThrough(frame, state);
+    }
+    if (frames - committed > lag) {
+        // Trace the best path back to the oldest frame that must be committed
+        int forced = frames - lag - 1;
+        state = bestState();
+        for (int t = frames - 1; t > forced; t--) {
+            state = backpointerColumn(t)[state];
+        }
+        commitThrough(forced, state);
+    }
+    return committed_states;
+}
+
+const std::vector<int>* StreamingViterbi::pushObservation(int observation) {
+    if (observation < 0 || observation >= hmm.numObservations()) return nullptr;
+    return &push(hmm.emissionRow(observation));
+}
+
+const std::vector<int>& StreamingViterbi::pushScores(const double* emission_scores) {
+    return push(emission_scores);
+}
+
+const std::vector<int>& StreamingViterbi::finish() {
+    committed_states.clear();
+    if (committed < frames) {
+        commitThrough(frames - 1, bestState());
+    }
+    return committed_states;
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <vector>
+#include "hmm.h"
+
+// Beam-pruned token-passing Viterbi
+//
+// Instead of scoring every state at every frame, only active states (tokens)
+// are expanded, along the successor lists of the model. After each frame the
+// tokens are pruned twice: everything more than `beam` below the best score is
+// dropped, and if more than `max_active` remain, a histogram of their scores
+// picks a tighter threshold that keeps about max_active. The cost per frame is
+// proportional to the active tokens and their successors, not to the model size.
+//
+// Every surviving token appends one (state, previous entry) record to a
+// backpointer arena, so traceback memory is proportional to the tokens that
+// survived rather than T x S. Token lists, scratch arrays and the arena are
+// reused across frames and across calls.
+//
+// With an infinite beam and max_active >= numStates() the result is the exact
+// Viterbi path. The model must be finalized (finalizeTopology) before decoding.
+
+struct BeamOptions {
+    double beam = 300.0;        // log-probability below the best token to keep
+    int max_active = 1000;      // histogram pruning cap
+};
+
+class BeamViterbiDecoder {
+private:
+    struct Token {
+        int state;
+        double score;
+        int arena_index;        // record of this token's frame in the arena
+    };
+
+    struct Backpointer {
+        int state;
+        int previous;           // arena index of the predecessor, -1 at frame 0
+    };
+
+    const HMM& hmm;
+    BeamOptions options;
+
+    std::vector<Token> active;
+    std::vector<Token> next_active;
+    std::vector<double> next_score;     // best incoming score per state this frame
+    std::vector<int> next_previous;     // arena index of that best predecessor
+    std::vector<int> next_slot;         // index in next_active, -1 if not reached
+    std::vector<Backpointer> arena;
+    std::vector<int> histogram;
+
+    double final_score = LOG_ZERO;
+    long expanded_tokens = 0;
+    int frames = 0;
+
+    void prune(std::vector<Token>& tokens);
+
+    template <typename EmissionRows>
+    std::vector<int> run(int T, EmissionRows emission_row);
+
+public:
+    BeamViterbiDecoder(const HMM& model, const BeamOptions& options = BeamOptions());
+
+    // Best state sequence; empty if nothing survives, an observation is out of
+    // range or the model is not finalized
+    std::vector<int> decode(const std::vector<int>& observations);
+
+    // Same on a precomputed T x numStates() emission score matrix (see HMM::viterbiScores)
+    std::vector<int> decodeScores(const double* scores, int T, int score_stride);
+
+    // Log probability of the last decoded path
+    double score() const { return final_score; }
+
+    // Average number of tokens alive per frame in the last decode
+    double averageActive() const { return frames > 0 ? (double)expanded_tokens / frames : 0.0; }
+};
+
+// Streaming Viterbi with partial traceback
+//
+// Frames are pushed one at a time and the states that can no longer change are
+// returned as soon as they are known, so recognition can drive feedback during
+// a recording. Only the current score column and the backpointers of the
+// frames not yet committed are kept.
+//
+// After each frame the survivor paths of all reachable states are traced back;
+// where they have merged into one state (the convergence point) every earlier
+// frame is committed, exactly as the offline Viterbi path would have it. If the
+// paths have not merged within `lag` frames, the oldest frames are committed
+// along the current best path instead (fixed-lag decoding), so memory and
+// latency never exceed `lag` frames. Such forced decisions may differ from the
+// offline path; lag = 0 commits the best state of every frame immediately.
+// The model must outlive the session.
+
+class StreamingViterbi {
+private:
+    const HMM& hmm;
+    int lag;
+
+    AlignedVector scores;               // Viterbi scores of the last frame
+    AlignedVector next_scores;
+    std::vector<int> backpointers;      // (lag + 1) x S ring, frame t at slot t % (lag + 1)
+    std::vector<int> frontier;          // traceback scratch: distinct states at one frame
+    std::vector<int> next_frontier;
+    std::vector<int> stamps;            // dedup marks for next_frontier
+    int stamp = 0;
+    std::vector<int> committed_states;  // returned by the last push or finish
+
+    int frames = 0;                     // frames pushed
+    int committed = 0;                  // frames [0, committed) are final
+
+    const int* backpointerColumn(int frame) const {
+        return backpointers.data() + (size_t)(frame % (lag + 1)) * hmm.numStates();
+    }
+    int convergencePoint(int& state);
+    void commitThrough(int frame, int state);
+    const std::vector<int>& push(const double* emission);
+
+public:
+    StreamingViterbi(const HMM& model, int lag);
+
+    // Start a new utterance
+    void reset();
+
+    // Decode one more frame; returns the states committed by it (frames
+    // committedCount() - size() .. committedCount() - 1). Null for an
+    // out-of-range observation, which is not decoded, so the caller can report
+    // it rather than have later frames silently shift by one.
+    const std::vector<int>* pushObservation(int observation);
+
+    // Same with the emission log-likelihoods of every state for the frame
+    // (e.g. one row of GMMEmissions::score)
+    const std::vector<int>& pushScores(const double* emission_scores);
+
+    // End of utterance: commit the remaining frames along the best final state
+    const std::vector<int>& finish();
+
+    int frameCount() const { return frames; }
+    int committedCount() const { return committed; }
+
+    // Most likely state of the latest frame so far, -1 before the first push
+    int bestState() const;
+    double bestScore() const;
+};
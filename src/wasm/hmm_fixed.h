@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <vector>
+#include "hmm.h"
+
+// Compile-time-sized kernels for small models
+//
+// Per-phoneme models have 3 or 5 emitting states. With the state count as a
+// template parameter the score columns and the transition matrix are
+// std::arrays on the stack, every inner loop has a constant trip count that the
+// compiler unrolls completely, and there is no per-call allocation besides the
+// Viterbi backpointers (kept in the caller's HMMWorkspace).
+//
+// Forward keeps alpha in the log domain but sums predecessors in the
+// probability domain: the transition matrix is exponentiated once, and each
+// frame the previous column is exponentiated relative to its own maximum, so a
+// frame costs S exp() and S log() calls instead of S^2 exp(). Emissions are
+// added in the log domain and never exponentiated, so however far apart the
+// states score, nothing reachable underflows. If a state's sum underflows or is
+// subnormal (all of its predecessors ~700 nats or more below the column
+// maximum), it is recomputed with log-sum-exp as in HMM::forward. Viterbi stays in the log domain with the same
+// tie breaking as HMM::viterbi, so paths are identical.
+//
+// makeHMMKernels() picks the fixed kernels for the common sizes and falls back
+// to the dynamic HMM for everything else.
+
+// Viterbi and forward over one model
+class HMMKernels {
+public:
+    virtual ~HMMKernels() = default;
+
+    // As HMM::viterbi / HMM::forward (empty or LOG_ZERO for invalid observations)
+    virtual std::vector<int> viterbi(const std::vector<int>& observations, HMMWorkspace& workspace) const = 0;
+    virtual double forward(const std::vector<int>& observations, HMMWorkspace& workspace) const = 0;
+
+    // As HMM::viterbiScores / HMM::forwardScores
+    virtual std::vector<int> viterbiScores(const double* scores, int T, int score_stride, HMMWorkspace& workspace) const = 0;
+    virtual double forwardScores(const double* scores, int T, int score_stride, HMMWorkspace& workspace) const = 0;
+};
+
+// The dynamic HMM behind the kernel interface
+class DynamicHMMKernels : public HMMKernels {
+private:
+    const HMM& hmm;
+
+public:
+    explicit DynamicHMMKernels(const HMM& model) : hmm(model) {}
+
+    std::vector<int> viterbi(const std::vector<int>& observations, HMMWorkspace& workspace) const override {
+        return hmm.viterbi(observations, workspace);
+    }
+    double forward(const std::vector<int>& observations, HMMWorkspace& workspace) const override {
+        return hmm.forward(observations, workspace);
+    }
+    std::vector<int> viterbiScores(const double* scores, int T, int score_stride, HMMWorkspace& workspace) const override {
+        return hmm.viterbiScores(scores, T, score_stride, workspace);
+    }
+    double forwardScores(const double* scores, int T, int score_stride, HMMWorkspace& workspace) const override {
+        return hmm.forwardScores(scores, T, score_stride, workspace);
+    }
+};
+
+// Kernels for a model with exactly S states. Initial and transition
+// parameters are copied; discrete emissions are read from the model, which
+// must outlive the kernels.
+template <int S>
+class FixedHMM : public HMMKernels {
+private:
+    typedef std::array<double, S> Column;
+
+    const HMM& hmm;
+    Column initial;                             // log
+    std::array<Column, S> transitions_in;       // log, [to][from]
+    std::array<Column, S> transition_probs_in;  // exp(transitions_in)
+
+    template <typename EmissionRows>
+    std::vector<int> viterbiKernel(int T, EmissionRows emission_row, HMMWorkspace& workspace) const {
+        if (workspace.backpointers.size() < (size_t)T * S) workspace.backpointers.resize((size_t)T * S);
+        int* backpointers = workspace.backpointers.data();
+
+        Column prev, cur;
+        const double* emission = emission_row(0);
+        for (int s = 0; s < S; s++) {
+            prev[s] = initial[s] + emission[s];
+        }
+
+        for (int t = 1; t < T; t++) {
+            emission = emission_row(t);
+            int* back = backpointers + (size_t)t * S;
+            for (int s = 0; s < S; s++) {
+                double best = prev[0] + transitions_in[s][0];
+                int best_prev = 0;
+                for (int p = 1; p < S; p++) {
+                    double score = prev[p] + transitions_in[s][p];
+                    if (score > best) {
+                        best = score;
+                        best_prev = p;
+                    }
+                }
+                cur[s] = best + emission[s];
+                back[s] = best_prev;
+            }
+            prev = cur;
+        }
+
+        std::vector<int> best_path(T);
+        best_path[T-1] = std::max_element(prev.begin(), prev.end()) - prev.begin();
+        for (int t = T-1; t > 0; t--) {
+            best_path[t-1] = backpointers[(size_t)t * S + best_path[t]];
+        }
+        return best_path;
+    }
+
+    template <typename EmissionRows>
+    double forwardKernel(int T, EmissionRows emission_row) const {
+        Column alpha, next, probs;
+        const double* emission = emission_row(0);
+        for (int s = 0; s < S; s++) {
+            alpha[s] = initial[s] <= LOG_ZERO ? LOG_ZERO : initial[s] + emission[s];
+        }
+
+        for (int t = 1; t < T; t++) {
+            double max_alpha = *std::max_element(alpha.begin(), alpha.end());
+            if (max_alpha <= LOG_ZERO) return LOG_ZERO;
+            for (int p = 0; p < S; p++) {
+                probs[p] = alpha[p] <= LOG_ZERO ? 0.0 : std::exp(alpha[p] - max_alpha);
+            }
+
+            emission = emission_row(t);
+            for (int s = 0; s < S; s++) {
+                double sum = 0.0;
+                for (int p = 0; p < S; p++) {
+                    sum += probs[p] * transition_probs_in[s][p];
+                }
+                double incoming;
+                if (sum >= std::numeric_limits<double>::min()) {
+                    incoming = max_alpha + std::log(sum);
+                } else {
+                    LogSumExpAccumulator total;
+                    for (int p = 0; p < S; p++) {
+                        if (alpha[p] > LOG_ZERO && transitions_in[s][p] > LOG_ZERO) total.add(alpha[p] + transitions_in[s][p]);
+                    }
+                    incoming = total.result();
+                }
+                next[s] = incoming <= LOG_ZERO ? LOG_ZERO : incoming + emission[s];
+            }
+            alpha = next;
+        }
+
+        LogSumExpAccumulator total;
+        for (int s = 0; s < S; s++) {
+            if (alpha[s] > LOG_ZERO) total.add(alpha[s]);
+        }
+        return total.result();
+    }
+
+public:
+    explicit FixedHMM(const HMM& model) : hmm(model) {
+        for (int s = 0; s < S; s++) {
+            initial[s] = model.initialLogProb(s);
+            for (int p = 0; p < S; p++) {
+                transitions_in[s][p] = model.transitionLogProb(p, s);
+                transition_probs_in[s][p] = transitions_in[s][p] <= LOG_ZERO ? 0.0 : std::exp(transitions_in[s][p]);
+            }
+        }
+    }
+
+    std::vector<int> viterbi(const std::vector<int>& observations, HMMWorkspace& workspace) const override {
+        if (observations.empty() || !hmm.validObservations(observations)) return {};
+        return viterbiKernel(observations.size(), [&](int t) { return hmm.emissionRow(observations[t]); }, workspace);
+    }
+
+    double forward(const std::vector<int>& observations, HMMWorkspace&) const override {
+        if (observations.empty() || !hmm.validObservations(observations)) return LOG_ZERO;
+        return forwardKernel(observations.size(), [&](int t) { return hmm.emissionRow(observations[t]); });
+    }
+
+    std::vector<int> viterbiScores(const double* scores, int T, int score_stride, HMMWorkspace& workspace) const override {
+        if (T <= 0) return {};
+        return viterbiKernel(T, [&](int t) { return scores + (size_t)t * score_stride; }, workspace);
+    }
+
+    double forwardScores(const double* scores, int T, int score_stride, HMMWorkspace&) const override {
+        if (T <= 0) return LOG_ZERO;
+        return forwardKernel(T, [&](int t) { return scores + (size_t)t * score_stride; });
+    }
+};
+
+// Fixed kernels for 3- and 5-state models, the dynamic HMM otherwise. The
+// model must outlive the returned kernels and not change while they are used.
+inline std::unique_ptr<HMMKernels> makeHMMKernels(const HMM& model) {
+    switch (model.numStates()) {
+        case 3: return std::unique_ptr<HMMKernels>(new FixedHMM<3>(model));
+        case 5: return std::unique_ptr<HMMKernels>(new FixedHMM<5>(model));
+        default: return std::unique_ptr<HMMKernels>(new DynamicHMMKernels(model));
+    }
+}
@@ -0,0 +1,197 @@
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include "hmm_model_file.h"
+
+static const uint64_t SECTION_ALIGNMENT = 64;
+
+// Sizes are computed in 64 bits, since size_t is 32 bits under wasm32 and
+// S * S floats wraps there for S >= 32768
+static uint64_t alignSection(uint64_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+static std::unique_ptr<HMMModel> fail(std::string* error, const char* message) {
+    if (error) *error = message;
+    return nullptr;
+}
+
+// Whether a model of this size can be held in memory: its parameters are
+// kept as doubles, the transitions twice, and GMMEmissions holds a few arrays
+// of states x components x dims
+static bool modelFitsInMemory(uint64_t states, uint64_t observations, uint64_t components, uint64_t dims) {
+    const uint64_t max_entries = std::numeric_limits<size_t>::max() / (4 * sizeof(double));
+    return states * states + observations * states + states * components * dims <= max_entries;
+}
+
+// Offsets of the means and variances, which follow the weights
+static void mixtureSections(const HMMModelHeader& header, uint64_t& means_offset, uint64_t& variances_offset) {
+    const uint64_t SK = (uint64_t)header.states * header.components;
+    means_offset = alignSection(header.mixtures_offset + SK * sizeof(float));
+    variances_offset = alignSection(means_offset + SK * header.dims * sizeof(float));
+}
+
+// Section offsets for a header's sizes; returns the total file size
+static uint64_t layoutSections(HMMModelHeader& header) {
+    const uint64_t S = header.states;
+    header.initial_offset = alignSection(sizeof(HMMModelHeader));
+    header.transitions_offset = alignSection(header.initial_offset + S * sizeof(float));
+    header.emissions_offset = alignSection(header.transitions_offset + S * S * sizeof(float));
+    header.mixtures_offset = alignSection(header.emissions_offset + (uint64_t)header.observations * S * sizeof(float));
+    if (header.components == 0) return header.mixtures_offset;
+    uint64_t means_offset, variances_offset;
+    mixtureSections(header, means_offset, variances_offset);
+    return variances_offset + S * header.components * header.dims * sizeof(float);
+}
+
+static float storedLogProb(double value) {
+    return value <= LOG_ZERO ? -std::numeric_limits<float>::infinity() : static_cast<float>(value);
+}
+
+std::vector<uint8_t> serializeHMMModel(const HMM& hmm, const HMMModelMixtures* mixtures, uint64_t config_hash) {
+    const int S = hmm.numStates(), O = hmm.numObservations();
+    const int K = mixtures ? mixtures->components : 0;
+    const int D = mixtures ? mixtures->dims : 0;
+
+    HMMModelHeader header = {};
+    memcpy(header.magic, HMM_MODEL_MAGIC, 4);
+    header.version = HMM_MODEL_VERSION;
+    header.states = S;
+    header.observations = O;
+    header.components = K;
+    header.dims = D;
+    header.config_hash = config_hash;
+    std::vector<uint8_t> bytes((size_t)layoutSections(header), 0);
+    memcpy(bytes.data(), &header, sizeof(header));
+
+    auto section = [&](uint64_t offset) { return reinterpret_cast<float*>(bytes.data() + offset); };
+    float* initial = section(header.initial_offset);
+    float* transitions = section(header.transitions_offset);
+    float* emissions = section(header.emissions_offset);
+    for (int s = 0; s < S; s++) {
+        initial[s] = storedLogProb(hmm.initialLogProb(s));
+        for (int to = 0; to < S; to++) {
+            transitions[(size_t)s * S + to] = storedLogProb(hmm.transitionLogProb(s, to));
+        }
+    }
+    for (int o = 0; o < O; o++) {
+        for (int s = 0; s < S; s++) {
+            emissions[(size_t)o * S + s] = storedLogProb(hmm.emissionLogProb(s, o));
+        }
+    }
+
+    if (K > 0) {
+        const size_t SK = (size_t)S * K;
+        uint64_t means_offset, variances_offset;
+        mixtureSections(header, means_offset, variances_offset);
+        float* weights = section(header.mixtures_offset);
+        float* means = section(means_offset);
+        float* variances = section(variances_offset);
+        for (size_t k = 0; k < SK; k++) {
+            weights[k] = storedLogProb(mixtures->weights[k] > 0 ? log(mixtures->weights[k]) : LOG_ZERO);
+        }
+        for (size_t k = 0; k < SK * D; k++) {
+            means[k] = static_cast<float>(mixtures->means[k]);
+            variances[k] = static_cast<float>(mixtures->variances[k]);
+        }
+    }
+    return bytes;
+}
+
+// Log probabilities must not be NaN or noticeably above 0
+static bool validLogProbs(const float* values, size_t count) {
+    for (size_t k = 0; k < count; k++) {
+        if (!(values[k] <= 1e-3f)) return false;
+    }
+    return true;
+}
+
+std::unique_ptr<HMMModel> parseHMMModel(const uint8_t* data, size_t length, std::string* error,
+                                        uint64_t* config_hash) {
+    if (length < sizeof(HMMModelHeader)) return fail(error, "HMM model is truncated");
+
+    HMMModelHeader h;
+    memcpy(&h, data, sizeof(h));
+    if (memcmp(h.magic, HMM_MODEL_MAGIC, 4) != 0) return fail(error, "not an HMM model (bad magic)");
+    if (h.version != HMM_MODEL_VERSION) return fail(error, "unsupported HMM model version");
+    if (h.states == 0 || h.states > (1u << 16)) return fail(error, "HMM model has an invalid state count");
+    if (h.observations == 0 && h.components == 0) return fail(error, "HMM model has no emissions");
+    if (h.components > 0 && h.dims == 0) return fail(error, "HMM model mixtures have no dimensions");
+    if (h.observations > (1u << 24) || h.components > (1u << 12) || h.dims > (1u << 12)) {
+        return fail(error, "HMM model is too large");
+    }
+    if (!modelFitsInMemory(h.states, h.observations, h.components, h.dims)) {
+        return fail(error, "HMM model is too large");
+    }
+
+    // The writer's layout is the only valid one, so recompute it and compare
+    HMMModelHeader expected = h;
+    const uint64_t total = layoutSections(expected);
+    if (h.initial_offset != expected.initial_offset || h.transitions_offset != expected.transitions_offset ||
+        h.emissions_offset != expected.emissions_offset || h.mixtures_offset != expected.mixtures_offset) {
+        return fail(error, "HMM model section offsets are invalid");
+    }
+    if (total > length) return fail(error, "HMM model section out of bounds");
+
+    // Sections are 64-byte aligned in the blob; copy if the blob itself is not float aligned
+    std::vector<float> copy;
+    const float* base = reinterpret_cast<const float*>(data);
+    if (reinterpret_cast<uintptr_t>(data) % alignof(float) != 0) {
+        copy.resize((size_t)total / sizeof(float));
+        memcpy(copy.data(), data, copy.size() * sizeof(float));
+        base = copy.data();
+    }
+    auto section = [&](uint64_t offset) { return base + offset / sizeof(float); };
+
+    const int S = h.states, O = h.observations, K = h.components, D = h.dims;
+    const float* initial = section(h.initial_offset);
+    const float* transitions = section(h.transitions_offset);
+    const float* emissions = section(h.emissions_offset);
+    if (!validLogProbs(initial, S) || !validLogProbs(transitions, (size_t)S * S) ||
+        !validLogProbs(emissions, (size_t)O * S)) {
+        return fail(error, "HMM model has invalid log probabilities");
+    }
+
+    std::unique_ptr<HMMModel> model(new HMMModel(S, O));
+    model->hmm.setLogProbabilities(initial, transitions, emissions);
+
+    if (K > 0) {
+        const size_t SK = (size_t)S * K;
+        uint64_t means_offset, variances_offset;
+        mixtureSections(h, means_offset, variances_offset);
+        const float* weights = section(h.mixtures_offset);
+        const float* means = section(means_offset);
+        const float* variances = section(variances_offset);
+        if (!validLogProbs(weights, SK)) return fail(error, "HMM model has invalid mixture weights");
+
+        model->emissions.reset(new GMMEmissions(S, K, D));
+        std::vector<double> mean(D), variance(D);
+        for (size_t k = 0; k < SK; k++) {
+            for (int d = 0; d < D; d++) {
+                mean[d] = means[k * D + d];
+                variance[d] = variances[k * D + d];
+                if (!std::isfinite(mean[d]) || !(variance[d] > 0) || !std::isfinite(variance[d])) {
+                    return fail(error, "HMM model has invalid mixture parameters");
+                }
+            }
+            double weight = std::isinf(weights[k]) ? 0.0 : exp((double)weights[k]);
+            model->emissions->setComponent(k / K, k % K, weight, mean.data(), variance.data());
+        }
+    }
+
+    if (config_hash) *config_hash = h.config_hash;
+    return model;
+}
+
+std::unique_ptr<HMMModel> modelFromLogProbs(int states, int observations, const float* values, size_t count,
+                                            std::string* error) {
+    if (states <= 0 || observations <= 0) return fail(error, "HMM model needs states and observations");
+    if (!modelFitsInMemory(states, observations, 0, 0)) return fail(error, "HMM model is too large");
+    const uint64_t S = states, O = observations;
+    if (count != S + S * S + O * S) return fail(error, "HMM model arrays have the wrong size");
+    if (!validLogProbs(values, count)) return fail(error, "HMM model has invalid log probabilities");
+
+    std::unique_ptr<HMMModel> model(new HMMModel(states, observations));
+    model->hmm.setLogProbabilities(values, values + S, values + S + S * S);
+    return model;
+}
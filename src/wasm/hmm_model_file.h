@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+#include "hmm_registry.h"
+
+// Binary HMM model file
+//
+// One model in a single blob, so it is installed with one call instead of one
+// call per parameter. Layout (little-endian, every section 64-byte aligned):
+//
+//   HMMModelHeader
+//   float initial[states]                       log probabilities
+//   float transitions[states][states]           [from][to], log probabilities
+//   float emissions[observations][states]       discrete models only, log probabilities
+//   float weights[states][components]           GMM models only, log weights
+//   float means[states * components][dims]
+//   float variances[states * components][dims]
+//
+// Impossible events are stored as -inf. The emission matrix is in the order
+// HMM keeps it, so loading is a straight copy. A model has discrete emissions
+// (observations > 0), GMM emissions (components > 0) or both.
+
+const char HMM_MODEL_MAGIC[4] = {'B', 'Q', 'H', 'M'};
+const uint16_t HMM_MODEL_VERSION = 1;
+
+struct HMMModelHeader {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t states;
+    uint32_t observations;      // discrete symbols, 0 if none
+    uint32_t components;        // mixture components per state, 0 if none
+    uint32_t dims;              // mixture feature dimensions
+    uint64_t config_hash;       // front end of the features (featureConfigHash), 0 if unknown
+    uint64_t initial_offset;
+    uint64_t transitions_offset;
+    uint64_t emissions_offset;
+    uint64_t mixtures_offset;   // weights, then means, then variances, each section aligned
+};
+
+static_assert(sizeof(HMMModelHeader) == 64, "model header layout");
+
+// Mixture parameters to write, as plain weights (states x components) and
+// (states x components) x dims means and variances
+struct HMMModelMixtures {
+    int components = 0;
+    int dims = 0;
+    const double* weights = nullptr;
+    const double* means = nullptr;
+    const double* variances = nullptr;
+};
+
+std::vector<uint8_t> serializeHMMModel(const HMM& hmm, const HMMModelMixtures* mixtures = nullptr,
+                                       uint64_t config_hash = 0);
+
+// Validate a blob and build the model from it; null with *error set if the
+// blob is truncated, has sections out of bounds or holds invalid values
+std::unique_ptr<HMMModel> parseHMMModel(const uint8_t* data, size_t length, std::string* error = nullptr,
+                                        uint64_t* config_hash = nullptr);
+
+// The same from bare arrays, as one float buffer holding initial, transitions
+// and emissions in the file order (e.g. a Float32Array built in JavaScript)
+std::unique_ptr<HMMModel> modelFromLogProbs(int states, int observations, const float* values, size_t count,
+                                            std::string* error = nullptr);
@@ -0,0 +1,60 @@
+#include "hmm_registry.h"
+
+int HMMRegistry::insert(std::shared_ptr<HMMModel> model, bool sealed) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t h = 0; h < entries.size(); h++) {
+        if (!entries[h].model) {
+            entries[h] = {std::move(model), sealed};
+            return h;
+        }
+    }
+    entries.push_back({std::move(model), sealed});
+    return entries.size() - 1;
+}
+
+int HMMRegistry::create(int states, int observations) {
+    return insert(std::make_shared<HMMModel>(states, observations), false);
+}
+
+int HMMRegistry::add(HMMModel model) {
+    return insert(std::make_shared<HMMModel>(std::move(model)), false);
+}
+
+HMMModel* HMMRegistry::edit(int handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (handle < 0 || handle >= (int)entries.size() || entries[handle].sealed) return nullptr;
+    return entries[handle].model.get();
+}
+
+std::shared_ptr<const HMMModel> HMMRegistry::get(int handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (handle < 0 || handle >= (int)entries.size() || !entries[handle].model) return nullptr;
+    Entry& entry = entries[handle];
+    if (!entry.sealed) {
+        entry.model->hmm.finalizeTopology();
+        entry.model->kernels = makeHMMKernels(entry.model->hmm);
+        entry.sealed = true;
+    }
+    return entry.model;
+}
+
+bool HMMRegistry::release(int handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (handle < 0 || handle >= (int)entries.size() || !entries[handle].model) return false;
+    entries[handle] = Entry();
+    return true;
+}
+
+void HMMRegistry::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+}
+
+int HMMRegistry::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    int count = 0;
+    for (const Entry& entry : entries) {
+        if (entry.model) count++;
+    }
+    return count;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "hmm.h"
+#include "gmm.h"
+#include "hmm_fixed.h"
+
+// A loaded model: the HMM and, for continuous observations, its GMM emissions
+struct HMMModel {
+    HMM hmm;
+    std::unique_ptr<GMMEmissions> emissions;    // null for discrete models
+    std::unique_ptr<HMMKernels> kernels;        // Viterbi/forward, set when sealed
+
+    HMMModel(int states, int observations) : hmm(states, observations) {}
+    explicit HMMModel(HMM model) : hmm(std::move(model)) {}
+};
+
+// Models referred to by integer handle, so any number of phoneme and word
+// models can be loaded side by side and reused across requests.
+//
+// A model is editable from create() until it is first looked up with get();
+// that seals it (finalizeTopology, plus fixed-size kernels for 3- and 5-state
+// models, see hmm_fixed.h) and from then on it is immutable. get()
+// hands out shared ownership, so a decode running on a worker thread keeps its
+// model alive even if the handle is released meanwhile, and any number of
+// threads can decode with the same model at once. Released handles are reused.
+class HMMRegistry {
+private:
+    struct Entry {
+        std::shared_ptr<HMMModel> model;
+        bool sealed = false;
+    };
+
+    mutable std::mutex mutex;
+    std::vector<Entry> entries;
+
+    int insert(std::shared_ptr<HMMModel> model, bool sealed);
+
+public:
+    // New editable model; returns its handle
+    int create(int states, int observations);
+
+    // Install a model built elsewhere (e.g. loaded from a model file); like a
+    // created one it stays editable until the first get()
+    int add(HMMModel model);
+
+    // The model for editing; null if the handle is unknown or already sealed.
+    // Editing is not synchronized: build a model on one thread, then share it.
+    HMMModel* edit(int handle);
+
+    // The model for decoding, sealing it on first use; null for unknown handles
+    std::shared_ptr<const HMMModel> get(int handle);
+
+    bool release(int handle);
+    void clear();
+
+    // Handles currently in use
+    int size() const;
+};
@@ -0,0 +1,345 @@
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "hmm_training.h"
+#include "thread_pool.h"
+
+// Baum-Welch training for GMM-HMMs
+
+HMM GMMHMMParameters::buildHMM() const {
+    HMM hmm(states, 0);
+    for (int s = 0; s < states; s++) {
+        hmm.setInitialProb(s, initial[s]);
+        for (int to = 0; to < states; to++) {
+            hmm.setTransitionProb(s, to, transitions[(size_t)s * states + to]);
+        }
+    }
+    hmm.finalizeTopology();
+    return hmm;
+}
+
+GMMEmissions GMMHMMParameters::buildEmissions() const {
+    GMMEmissions emissions(states, components, dims);
+    for (int index = 0; index < states * components; index++) {
+        emissions.setComponent(index / components, index % components, weights[index],
+                               means.data() + (size_t)index * dims, variances.data() + (size_t)index * dims);
+    }
+    return emissions;
+}
+
+GMMHMMParameters flatStartParameters(const std::vector<TrainingUtterance>& utterances,
+                                     int states, int components, int dims,
+                                     bool left_to_right, double variance_floor) {
+    GMMHMMParameters parameters;
+    parameters.states = states;
+    parameters.components = components;
+    parameters.dims = dims;
+
+    // First and second moments of the frames falling in each state's segment
+    std::vector<double> count(states, 0.0), sum((size_t)states * dims, 0.0), sum_sq((size_t)states * dims, 0.0);
+    for (const TrainingUtterance& utterance : utterances) {
+        for (int t = 0; t < utterance.rows; t++) {
+            const int s = std::min(states - 1, (int)((long)t * states / utterance.rows));
+            const double* x = utterance.frames.data() + (size_t)t * dims;
+            count[s] += 1.0;
+            for (int d = 0; d < dims; d++) {
+                sum[(size_t)s * dims + d] += x[d];
+                sum_sq[(size_t)s * dims + d] += x[d] * x[d];
+            }
+        }
+    }
+
+    parameters.weights.assign((size_t)states * components, 1.0 / components);
+    parameters.means.resize((size_t)states * components * dims);
+    parameters.variances.resize((size_t)states * components * dims);
+    for (int s = 0; s < states; s++) {
+        for (int k = 0; k < components; k++) {
+            const double spread = components > 1 ? 0.2 * (2.0 * k / (components - 1) - 1.0) : 0.0;
+            double* mean = parameters.means.data() + ((size_t)s * components + k) * dims;
+            double* variance = parameters.variances.data() + ((size_t)s * components + k) * dims;
+            for (int d = 0; d < dims; d++) {
+                const double n = std::max(count[s], 1.0);
+                const double mu = sum[(size_t)s * dims + d] / n;
+                const double var = std::max(variance_floor, sum_sq[(size_t)s * dims + d] / n - mu * mu);
+                mean[d] = mu + spread * std::sqrt(var);
+                variance[d] = var;
+            }
+        }
+    }
+
+    parameters.initial.assign(states, left_to_right ? 0.0 : 1.0 / states);
+    parameters.transitions.assign((size_t)states * states, left_to_right ? 0.0 : 1.0 / states);
+    if (left_to_right) {
+        parameters.initial[0] = 1.0;
+        for (int s = 0; s < states; s++) {
+            if (s + 1 < states) {
+                parameters.transitions[(size_t)s * states + s] = 0.6;
+                parameters.transitions[(size_t)s * states + s + 1] = 0.4;
+            } else {
+                parameters.transitions[(size_t)s * states + s] = 1.0;
+            }
+        }
+    }
+    return parameters;
+}
+
+// Expected counts summed over the utterances of one worker
+struct BaumWelchAccumulator {
+    double log_likelihood = 0.0;
+    long frames = 0;
+    int utterances = 0;
+    std::vector<double> initial;        // states
+    std::vector<double> transitions;    // states x states
+    std::vector<double> occupancy;      // states x components
+    std::vector<double> first_moment;   // (states x components) x dims
+    std::vector<double> second_moment;  // (states x components) x dims
+
+    // Scratch reused across utterances
+    std::vector<double> component_scores, emission_scores, alpha, beta;
+
+    void reset(const GMMHMMParameters& p) {
+        log_likelihood = 0.0;
+        frames = 0;
+        utterances = 0;
+        initial.assign(p.states, 0.0);
+        transitions.assign((size_t)p.states * p.states, 0.0);
+        occupancy.assign((size_t)p.states * p.components, 0.0);
+        first_moment.assign((size_t)p.states * p.components * p.dims, 0.0);
+        second_moment.assign((size_t)p.states * p.components * p.dims, 0.0);
+    }
+
+    void merge(const BaumWelchAccumulator& other) {
+        log_likelihood += other.log_likelihood;
+        frames += other.frames;
+        utterances += other.utterances;
+        auto add = [](std::vector<double>& into, const std::vector<double>& from) {
+            for (size_t i = 0; i < into.size(); i++) into[i] += from[i];
+        };
+        add(initial, other.initial);
+        add(transitions, other.transitions);
+        add(occupancy, other.occupancy);
+        add(first_moment, other.first_moment);
+        add(second_moment, other.second_moment);
+    }
+};
+
+// Log-domain forward-backward over one utterance, adding its expected counts
+static void accumulateUtterance(const TrainingUtterance& utterance,
+                                const GMMHMMParameters& p,
+                                const std::vector<double>& log_initial,
+                                const std::vector<double>& log_transitions,
+                                const GMMEmissions& emissions,
+                                BaumWelchAccumulator& acc) {
+    const int T = utterance.rows;
+    const int S = p.states;
+    const int K = p.components;
+    const int D = p.dims;
+    if (T == 0) return;
+
+    acc.component_scores.resize((size_t)T * S * K);
+    acc.emission_scores.resize((size_t)T * S);
+    acc.alpha.resize((size_t)T * S);
+    acc.beta.resize((size_t)T * S);
+    double* component_scores = acc.component_scores.data();
+    double* B = acc.emission_scores.data();
+    double* alpha = acc.alpha.data();
+    double* beta = acc.beta.data();
+
+    for (int t = 0; t < T; t++) {
+        double* components = component_scores + (size_t)t * S * K;
+        emissions.scoreComponents(utterance.frames.data() + (size_t)t * D, components);
+        for (int s = 0; s < S; s++) {
+            LogSumExpAccumulator total;
+            for (int k = 0; k < K; k++) total.add(components[s * K + k]);
+            B[(size_t)t * S + s] = total.result();
+        }
+    }
+
+    for (int s = 0; s < S; s++) {
+        alpha[s] = log_initial[s] == LOG_ZERO ? LOG_ZERO : log_initial[s] + B[s];
+    }
+    for (int t = 1; t < T; t++) {
+        for (int s = 0; s < S; s++) {
+            LogSumExpAccumulator total;
+            for (int from = 0; from < S; from++) {
+                const double a = log_transitions[(size_t)from * S + s];
+                if (a != LOG_ZERO && alpha[(size_t)(t-1) * S + from] != LOG_ZERO) {
+                    total.add(alpha[(size_t)(t-1) * S + from] + a);
+                }
+            }
+            const double sum = total.result();
+            alpha[(size_t)t * S + s] = sum == LOG_ZERO ? LOG_ZERO : sum + B[(size_t)t * S + s];
+        }
+    }
+
+    std::fill(beta + (size_t)(T-1) * S, beta + (size_t)T * S, 0.0);
+    for (int t = T-2; t >= 0; t--) {
+        for (int s = 0; s < S; s++) {
+            LogSumExpAccumulator total;
+            for (int to = 0; to < S; to++) {
+                const double a = log_transitions[(size_t)s * S + to];
+                if (a != LOG_ZERO && beta[(size_t)(t+1) * S + to] != LOG_ZERO) {
+                    total.add(a + B[(size_t)(t+1) * S + to] + beta[(size_t)(t+1) * S + to]);
+                }
+            }
+            beta[(size_t)t * S + s] = total.result();
+        }
+    }
+
+    LogSumExpAccumulator total;
+    for (int s = 0; s < S; s++) total.add(alpha[(size_t)(T-1) * S + s]);
+    const double L = total.result();
+    if (L == LOG_ZERO || !std::isfinite(L)) return;
+
+    acc.log_likelihood += L;
+    acc.frames += T;
+    acc.utterances++;
+
+    for (int t = 0; t < T; t++) {
+        const double* x = utterance.frames.data() + (size_t)t * D;
+        for (int s = 0; s < S; s++) {
+            const double a = alpha[(size_t)t * S + s], b = beta[(size_t)t * S + s];
+            if (a == LOG_ZERO || b == LOG_ZERO) continue;
+            const double gamma = std::exp(a + b - L);
+            if (t == 0) acc.initial[s] += gamma;
+
+            // Transitions out of s into frame t + 1
+            if (t + 1 < T) {
+                for (int to = 0; to < S; to++) {
+                    const double log_a = log_transitions[(size_t)s * S + to];
+                    const double next = beta[(size_t)(t+1) * S + to];
+                    if (log_a == LOG_ZERO || next == LOG_ZERO) continue;
+                    acc.transitions[(size_t)s * S + to] += std::exp(a + log_a + B[(size_t)(t+1) * S + to] + next - L);
+                }
+            }
+
+            // Split the state occupancy over its components
+            const double* components = component_scores + (size_t)t * S * K + (size_t)s * K;
+            for (int k = 0; k < K; k++) {
+                if (components[k] == LOG_ZERO) continue;
+                const double posterior = gamma * std::exp(components[k] - B[(size_t)t * S + s]);
+                const size_t index = (size_t)s * K + k;
+                acc.occupancy[index] += posterior;
+                double* m1 = acc.first_moment.data() + index * D;
+                double* m2 = acc.second_moment.data() + index * D;
+                for (int d = 0; d < D; d++) {
+                    m1[d] += posterior * x[d];
+                    m2[d] += posterior * x[d] * x[d];
+                }
+            }
+        }
+    }
+}
+
+// E-step over all utterances with the current parameters. Worker w takes
+// utterances w, w + workers, ... so every run sums the same utterances into the
+// same accumulator and results are reproducible. The totals end up in
+// accumulators[0].
+static void expectedCounts(const GMMHMMParameters& p,
+                           const std::vector<TrainingUtterance>& utterances,
+                           ThreadPool& pool,
+                           std::vector<BaumWelchAccumulator>& accumulators) {
+    const int S = p.states;
+    std::vector<double> log_initial(S), log_transitions((size_t)S * S);
+    for (int s = 0; s < S; s++) {
+        log_initial[s] = p.initial[s] > 0 ? std::log(p.initial[s]) : LOG_ZERO;
+    }
+    for (size_t i = 0; i < log_transitions.size(); i++) {
+        log_transitions[i] = p.transitions[i] > 0 ? std::log(p.transitions[i]) : LOG_ZERO;
+    }
+    const GMMEmissions emissions = p.buildEmissions();
+
+    const int workers = std::max(1, std::min(pool.size(), (int)utterances.size()));
+    accumulators.resize(workers);
+    pool.parallelFor(workers, [&](int w) {
+        BaumWelchAccumulator& acc = accumulators[w];
+        acc.reset(p);
+        for (size_t u = w; u < utterances.size(); u += workers) {
+            accumulateUtterance(utterances[u], p, log_initial, log_transitions, emissions, acc);
+        }
+    });
+    for (int w = 1; w < workers; w++) {
+        accumulators[0].merge(accumulators[w]);
+    }
+}
+
+double averageLogLikelihood(const GMMHMMParameters& parameters,
+                            const std::vector<TrainingUtterance>& utterances,
+                            ThreadPool& pool) {
+    std::vector<BaumWelchAccumulator> accumulators;
+    expectedCounts(parameters, utterances, pool, accumulators);
+    const BaumWelchAccumulator& acc = accumulators[0];
+    return acc.utterances == 0 ? LOG_ZERO : acc.log_likelihood / std::max(1L, acc.frames);
+}
+
+double baumWelchIteration(GMMHMMParameters& p,
+                          const std::vector<TrainingUtterance>& utterances,
+                          ThreadPool& pool,
+                          double variance_floor) {
+    const int S = p.states;
+    const int K = p.components;
+    const int D = p.dims;
+
+    std::vector<BaumWelchAccumulator> accumulators;
+    expectedCounts(p, utterances, pool, accumulators);
+    const BaumWelchAccumulator& acc = accumulators[0];
+    if (acc.utterances == 0) {
+        return LOG_ZERO;
+    }
+
+    // M-step. Rows and components without expected counts keep their values.
+    for (int s = 0; s < S; s++) {
+        p.initial[s] = acc.initial[s] / acc.utterances;
+
+        double row_total = 0.0;
+        for (int to = 0; to < S; to++) row_total += acc.transitions[(size_t)s * S + to];
+        if (row_total > 0) {
+            for (int to = 0; to < S; to++) {
+                p.transitions[(size_t)s * S + to] = acc.transitions[(size_t)s * S + to] / row_total;
+            }
+        }
+
+        // A starved component keeps its old weight, so the state's weights are
+        // renormalised to sum to 1 again
+        double state_total = 0.0;
+        for (int k = 0; k < K; k++) state_total += acc.occupancy[(size_t)s * K + k];
+        bool skipped = false;
+        for (int k = 0; k < K; k++) {
+            const size_t index = (size_t)s * K + k;
+            const double occupancy = acc.occupancy[index];
+            if (occupancy < 1e-6) {
+                skipped = true;
+                continue;
+            }
+            p.weights[index] = occupancy / state_total;
+            for (int d = 0; d < D; d++) {
+                const double mean = acc.first_moment[index * D + d] / occupancy;
+                p.means[index * D + d] = mean;
+                p.variances[index * D + d] = std::max(variance_floor, acc.second_moment[index * D + d] / occupancy - mean * mean);
+            }
+        }
+        if (skipped) {
+            double weight_total = 0.0;
+            for (int k = 0; k < K; k++) weight_total += p.weights[(size_t)s * K + k];
+            if (weight_total > 0) {
+                for (int k = 0; k < K; k++) p.weights[(size_t)s * K + k] /= weight_total;
+            }
+        }
+    }
+
+    return acc.log_likelihood / std::max(1L, acc.frames);
+}
+
+std::vector<double> trainBaumWelch(GMMHMMParameters& parameters,
+                                   const std::vector<TrainingUtterance>& utterances,
+                                   ThreadPool& pool,
+                                   const BaumWelchOptions& options) {
+    std::vector<double> history;
+    for (int iteration = 0; iteration < options.iterations; iteration++) {
+        double log_likelihood = baumWelchIteration(parameters, utterances, pool, options.variance_floor);
+        history.push_back(log_likelihood);
+        if (log_likelihood == LOG_ZERO) break;
+        if (history.size() >= 2 && log_likelihood - history[history.size() - 2] < options.tolerance) break;
+    }
+    return history;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+#include "hmm.h"
+#include "gmm.h"
+
+// Baum-Welch (EM) training of HMMs with diagonal-covariance GMM emissions
+//
+// Each iteration runs log-domain forward-backward over every utterance (the
+// E-step) and re-estimates initial, transition and mixture parameters from the
+// expected counts (the M-step). Utterances are spread over a thread pool; each
+// worker sums into its own accumulator and the accumulators are merged once per
+// iteration, so workers never share writable state. Transitions that are zero
+// stay zero, so a left-to-right topology is kept.
+
+class ThreadPool;
+
+// Model parameters as plain probabilities
+struct GMMHMMParameters {
+    int states = 0;
+    int components = 0;             // per state
+    int dims = 0;
+    std::vector<double> initial;    // states
+    std::vector<double> transitions;// states x states, [from][to]
+    std::vector<double> weights;    // states x components
+    std::vector<double> means;      // (states x components) x dims
+    std::vector<double> variances;  // (states x components) x dims
+
+    HMM buildHMM() const;
+    GMMEmissions buildEmissions() const;
+};
+
+// One training sequence: frames x dims, row-major
+struct TrainingUtterance {
+    std::vector<double> frames;
+    int rows = 0;
+};
+
+struct BaumWelchOptions {
+    int iterations = 20;
+    double tolerance = 1e-4;        // stop when the per-frame log-likelihood gains less
+    double variance_floor = 1e-3;
+};
+
+// Flat start: every utterance is cut into `states` equal segments, and each
+// state's components start at the mean of its segments (spread by +-0.2 standard
+// deviations when there are several) with the segments' variance. Left-to-right
+// models start in state 0 and allow s -> s and s -> s + 1; otherwise every
+// transition is allowed.
+GMMHMMParameters flatStartParameters(const std::vector<TrainingUtterance>& utterances,
+                                     int states, int components, int dims,
+                                     bool left_to_right, double variance_floor = 1e-3);
+
+// One EM iteration in place. Returns the average log-likelihood per frame of the
+// parameters before the update; utterances the model cannot produce are skipped.
+double baumWelchIteration(GMMHMMParameters& parameters,
+                          const std::vector<TrainingUtterance>& utterances,
+                          ThreadPool& pool,
+                          double variance_floor = 1e-3);
+
+// Average log-likelihood per frame of the parameters as they are (an E-step
+// without update), e.g. of a model after its last iteration; LOG_ZERO if it
+// can produce none of the utterances
+double averageLogLikelihood(const GMMHMMParameters& parameters,
+                            const std::vector<TrainingUtterance>& utterances,
+                            ThreadPool& pool);
+
+// Iterate until options.iterations or convergence; returns the per-frame
+// log-likelihood of every iteration
+std::vector<double> trainBaumWelch(GMMHMMParameters& parameters,
+                                   const std::vector<TrainingUtterance>& utterances,
+                                   ThreadPool& pool,
+                                   const BaumWelchOptions& options = BaumWelchOptions());
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <algorithm>
+
+// Fixed-size worker pool for data-parallel loops
+// Used by the wavefront DTW and the native batch tools. In Emscripten builds
+// without pthreads there is no worker to start, so all work runs on the caller.
+
+inline int hardwareThreads() {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    return 1;
+#else
+    return std::max(1u, std::thread::hardware_concurrency());
+#endif
+}
+
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+
+    const std::function<void(int)>* job = nullptr;
+    int job_count = 0;
+    std::atomic<int> next_index{0};
+    int active_workers = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+
+    // Claim indices until the current job is exhausted
+    void drain(const std::function<void(int)>& fn, int count) {
+        for (int index = next_index++; index < count; index = next_index++) {
+            fn(index);
+        }
+    }
+
+    void workerLoop() {
+        unsigned seen_generation = 0;
+        for (;;) {
+            const std::function<void(int)>* current;
+            int count;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                work_ready.wait(lock, [&] { return stopping || generation != seen_generation; });
+                if (stopping) return;
+                seen_generation = generation;
+                // Woke after the caller already finished this job on its own
+                if (!job) continue;
+                current = job;
+                count = job_count;
+                active_workers++;
+            }
+
+            drain(*current, count);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--active_workers == 0) {
+                work_done.notify_all();
+            }
+        }
+    }
+
+public:
+    // num_threads <= 0 uses every hardware thread; the caller counts as one
+    explicit ThreadPool(int num_threads = 0) {
+        int total = num_threads > 0 ? num_threads : hardwareThreads();
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+        total = 1;
+#endif
+        for (int i = 1; i < total; i++) {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        work_ready.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return workers.size() + 1; }
+
+    // Run fn(index) for every index in [0, count) and return once all calls finished.
+    // Not reentrant: fn must not call parallelFor on the same pool.
+    void parallelFor(int count, const std::function<void(int)>& fn) {
+        if (count <= 0) return;
+        if (workers.empty() || count == 1) {
+            for (int index = 0; index < count; index++) fn(index);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            job_count = count;
+            next_index = 0;
+            generation++;
+        }
+        work_ready.notify_all();
+
+        drain(fn, count);
+
+        // Wait for workers that picked up this generation to finish their last index
+        std::unique_lock<std::mutex> lock(mutex);
+        work_done.wait(lock, [&] { return active_workers == 0; });
+        job = nullptr;
+    }
+};
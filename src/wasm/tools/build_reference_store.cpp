@@ -0,0 +1,313 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <sys/stat.h>
+#include "../audio_processor.h"
+#include "../feature_store.h"
+#include "../thread_pool.h"
+#include "json_reader.h"
+#include "wav_reader.h"
+
+// Offline reference-feature builder
+//
+// Walks the audio manifest, decodes every word's recording, runs the same MFCC
+// front end the browser uses (audio_processor.cpp) and writes the binary
+// reference store loaded by WasmAnalysisService.loadReferenceStore().
+//
+// Rebuilds are incremental: features of every word are also kept in a float32
+// cache store next to the output, together with the size and mtime of the file
+// they came from. Only words whose audio changed (or that are new) are decoded
+// again; a change of front-end configuration invalidates the whole cache.
+//
+// The manifest lists .mp3 files. There is no MP3 decoder here, so each entry is
+// read from a .wav file with the same name (convert with e.g.
+// `ffmpeg -i 001_001_001.mp3 001_001_001.wav`); a .wav entry is read directly.
+
+struct WordJob {
+    int surah;
+    int ayah;
+    int word;
+    std::string path;    // resolved .wav path, empty if not found
+    long long size = 0;
+    long long mtime = 0;
+};
+
+struct BuildOptions {
+    std::string manifest = "audio/audio_manifest.json";
+    std::string audio_dir;          // default: the manifest's directory
+    std::string output = "public/reference_features.bqfs";
+    int frame_length = 2048;        // WasmAnalysisService bufferSize
+    int hop_size = 512;             // WasmAnalysisService hopSize
+    int threads = 0;
+    bool int8 = false;
+    bool force = false;
+};
+
+static void printUsage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --manifest PATH      audio manifest (default audio/audio_manifest.json)\n"
+            "  --audio-dir DIR      directory with the word recordings (default: manifest dir)\n"
+            "  --output PATH        feature store to write (default public/reference_features.bqfs)\n"
+            "  --frame-length N     analysis frame in samples (default 2048)\n"
+            "  --hop N              hop between frames in samples (default 512)\n"
+            "  --threads N          worker threads (default: all cores)\n"
+            "  --int8               quantise the payload to int8\n"
+            "  --force              ignore the incremental cache\n",
+            program);
+}
+
+static bool parseOptions(int argc, char** argv, BuildOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--manifest" && has_value) options.manifest = argv[++i];
+        else if (arg == "--audio-dir" && has_value) options.audio_dir = argv[++i];
+        else if (arg == "--output" && has_value) options.output = argv[++i];
+        else if (arg == "--frame-length" && has_value) options.frame_length = atoi(argv[++i]);
+        else if (arg == "--hop" && has_value) options.hop_size = atoi(argv[++i]);
+        else if (arg == "--threads" && has_value) options.threads = atoi(argv[++i]);
+        else if (arg == "--int8") options.int8 = true;
+        else if (arg == "--force") options.force = true;
+        else return false;
+    }
+    if (options.audio_dir.empty()) {
+        size_t slash = options.manifest.find_last_of('/');
+        options.audio_dir = slash == std::string::npos ? "." : options.manifest.substr(0, slash);
+    }
+    return options.frame_length > 0 && options.hop_size > 0;
+}
+
+static bool statFile(const std::string& path, long long& size, long long& mtime) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) return false;
+    size = info.st_size;
+    mtime = info.st_mtime;
+    return true;
+}
+
+// Prefer a .wav next to the listed file; fall back to the listed file if it is a .wav
+static std::string resolveAudio(const std::string& audio_dir, const std::string& listed, long long& size, long long& mtime) {
+    std::string stem = listed.substr(0, listed.find_last_of('.'));
+    std::string candidates[] = {audio_dir + "/" + stem + ".wav", audio_dir + "/" + listed};
+    for (const std::string& candidate : candidates) {
+        size_t dot = candidate.find_last_of('.');
+        if (candidate.compare(dot, std::string::npos, ".wav") == 0 && statFile(candidate, size, mtime)) {
+            return candidate;
+        }
+    }
+    return "";
+}
+
+// Manifest layout: { "surah_<n>": { "verses": [ { "verse_number": n, "words": [ { "audio": file } ] } ] } }
+static bool readManifest(const BuildOptions& options, std::vector<WordJob>& jobs, std::vector<std::string>& missing) {
+    std::ifstream file(options.manifest);
+    if (!file) {
+        fprintf(stderr, "Cannot read manifest %s\n", options.manifest.c_str());
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    JsonValue root;
+    JsonReader reader(text);
+    if (!reader.parse(root) || !root.isObject()) {
+        fprintf(stderr, "Invalid manifest %s: %s\n", options.manifest.c_str(), reader.error().c_str());
+        return false;
+    }
+
+    for (const auto& member : root.object) {
+        if (member.first.compare(0, 6, "surah_") != 0) continue;
+        int surah = atoi(member.first.c_str() + 6);
+        const JsonValue& verses = member.second["verses"];
+        if (surah <= 0 || !verses.isArray()) continue;
+
+        for (const JsonValue& verse : verses.array) {
+            int ayah = (int)verse["verse_number"].number;
+            const JsonValue& words = verse["words"];
+            if (ayah <= 0 || !words.isArray()) continue;
+
+            for (size_t w = 0; w < words.array.size(); w++) {
+                const JsonValue& audio = words.array[w]["audio"];
+                if (!audio.isString()) continue;
+
+                WordJob job;
+                job.surah = surah;
+                job.ayah = ayah;
+                job.word = (int)w + 1;
+                job.path = resolveAudio(options.audio_dir, audio.string, job.size, job.mtime);
+                if (job.path.empty()) {
+                    missing.push_back(audio.string);
+                    continue;
+                }
+                jobs.push_back(job);
+            }
+        }
+    }
+    return true;
+}
+
+typedef std::tuple<int, int, int> WordKey;
+
+struct CacheEntry {
+    std::string path;
+    long long size;
+    long long mtime;
+    uint32_t frame_offset;
+    uint32_t frame_count;
+};
+
+// The cache index is text: a header line with the config hash, then one line per
+// word: surah ayah word size mtime path
+static std::map<WordKey, CacheEntry> loadCache(const std::string& cache_path, uint64_t config_hash, FeatureStore& cache_store) {
+    std::map<WordKey, CacheEntry> entries;
+    std::ifstream index(cache_path + ".idx");
+    std::string header;
+    if (!index || !std::getline(index, header) || header != "bqfs-cache 1 " + featureConfigHashHex(config_hash)) {
+        return entries;
+    }
+    if (!cache_store.openFile(cache_path) || cache_store.configHash() != config_hash) {
+        cache_store.close();
+        return entries;
+    }
+
+    std::string line;
+    while (std::getline(index, line)) {
+        std::istringstream fields(line);
+        int surah, ayah, word;
+        CacheEntry entry;
+        if (!(fields >> surah >> ayah >> word >> entry.size >> entry.mtime)) continue;
+        fields.get();
+        std::getline(fields, entry.path);
+
+        const WordEntry* stored = cache_store.findWord(surah, ayah, word);
+        if (!stored) continue;
+        entry.frame_offset = stored->frame_offset;
+        entry.frame_count = stored->frame_count;
+        entries[WordKey(surah, ayah, word)] = entry;
+    }
+    return entries;
+}
+
+int main(int argc, char** argv) {
+    BuildOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    const uint64_t config_hash = featureConfigHash(frontEndConfig(options.frame_length, options.hop_size));
+    const std::string cache_path = options.output + ".cache";
+
+    std::vector<WordJob> jobs;
+    std::vector<std::string> missing;
+    if (!readManifest(options, jobs, missing)) {
+        return 1;
+    }
+
+    FeatureStore cache_store;
+    std::map<WordKey, CacheEntry> cache;
+    if (!options.force) {
+        cache = loadCache(cache_path, config_hash, cache_store);
+    }
+
+    // Split into words reusable from the cache and words to decode
+    std::vector<FeatureMatrix> features(jobs.size());
+    std::vector<size_t> pending;
+    for (size_t k = 0; k < jobs.size(); k++) {
+        const WordJob& job = jobs[k];
+        auto found = cache.find(WordKey(job.surah, job.ayah, job.word));
+        if (found != cache.end() && found->second.path == job.path &&
+            found->second.size == job.size && found->second.mtime == job.mtime) {
+            features[k] = cache_store.frames(found->second.frame_offset, found->second.frame_count);
+        } else {
+            pending.push_back(k);
+        }
+    }
+
+    ThreadPool pool(options.threads);
+    fprintf(stderr, "%zu words in manifest: %zu cached, %zu to process on %d threads\n",
+            jobs.size() + missing.size(), jobs.size() - pending.size(), pending.size(), pool.size());
+
+    std::vector<std::string> errors(jobs.size());
+    std::atomic<int> done{0};
+    std::mutex progress_mutex;
+
+    pool.parallelFor(pending.size(), [&](int p) {
+        size_t k = pending[p];
+        WavAudio audio;
+        std::string error;
+        if (!readWavFile(jobs[k].path, audio, &error)) {
+            errors[k] = error;
+        } else {
+            auto samples = resampleLinear(audio.samples, audio.sample_rate, SAMPLE_RATE);
+            auto frames = computeMFCCFrames(samples, options.frame_length, options.hop_size);
+            if (frames.empty()) {
+                errors[k] = "shorter than one analysis frame";
+            } else {
+                features[k] = toFeatureMatrix(frames);
+            }
+        }
+
+        int finished = ++done;
+        if (finished % 100 == 0 || finished == (int)pending.size()) {
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            fprintf(stderr, "\r  processed %d/%zu", finished, pending.size());
+            if (finished == (int)pending.size()) fprintf(stderr, "\n");
+        }
+    });
+
+    // Assemble the output and the float32 cache from the same features
+    FeatureStoreWriter writer(NUM_MFCC_COEFFS, config_hash, options.int8 ? PAYLOAD_INT8 : PAYLOAD_FLOAT32);
+    FeatureStoreWriter cache_writer(NUM_MFCC_COEFFS, config_hash, PAYLOAD_FLOAT32);
+    std::ostringstream cache_index;
+    cache_index << "bqfs-cache 1 " << featureConfigHashHex(config_hash) << "\n";
+
+    int failed = 0;
+    for (size_t k = 0; k < jobs.size(); k++) {
+        const WordJob& job = jobs[k];
+        if (!errors[k].empty()) {
+            fprintf(stderr, "  skipped %s: %s\n", job.path.c_str(), errors[k].c_str());
+            failed++;
+            continue;
+        }
+        writer.addWord(job.surah, job.ayah, job.word, features[k]);
+        cache_writer.addWord(job.surah, job.ayah, job.word, features[k]);
+        cache_index << job.surah << " " << job.ayah << " " << job.word << " "
+                    << job.size << " " << job.mtime << " " << job.path << "\n";
+    }
+    features.clear();
+    cache_store.close();
+
+    std::string error;
+    if (!writer.writeFile(options.output, &error)) {
+        fprintf(stderr, "Cannot write %s: %s\n", options.output.c_str(), error.c_str());
+        return 1;
+    }
+
+    // Drop the index first so an interrupted update never pairs it with another store
+    std::remove((cache_path + ".idx").c_str());
+    bool cached = cache_writer.writeFile(cache_path, &error);
+    if (cached) {
+        std::ofstream index_file(cache_path + ".idx");
+        cached = static_cast<bool>(index_file << cache_index.str());
+    }
+    if (!cached) {
+        fprintf(stderr, "Warning: cannot update cache %s; the next build will start over\n", cache_path.c_str());
+    }
+
+    if (!missing.empty()) {
+        fprintf(stderr, "%zu manifest entries have no .wav (first: %s)\n", missing.size(), missing[0].c_str());
+    }
+    fprintf(stderr, "Wrote %s: %zu words, config %s%s\n", options.output.c_str(), jobs.size() - failed,
+            featureConfigHashHex(config_hash).c_str(), failed ? " (some words skipped)" : "");
+    return 0;
+}
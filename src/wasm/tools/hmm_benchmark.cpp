@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+#include "../hmm.h"
+#include "../hmm_decoder.h"
+#include "../hmm_fixed.h"
+
+// Speed of the HMM kernels on the flat, aligned parameter layout against the
+// previous nested-vector implementation (kept below as LegacyHMM).
+//
+// A random model is built at each state count and the same observation
+// sequence is decoded by both. --topology bakis builds a left-to-right model
+// (self, next and skip transitions), which runs on the sparse kernels. Reported
+// per kernel: microseconds per call and the speedup; the tool fails if paths or
+// likelihoods disagree.
+//
+// The beam-pruned decoder is then timed against exact Viterbi with --beam and
+// --max-active, reporting the average active tokens per frame and the fraction
+// of frames on which the two paths agree. An unpruned beam decode must
+// reproduce the exact path.
+//
+// Finally the compile-time-sized kernels (hmm_fixed.h) are timed against the
+// dynamic HMM on 3- and 5-state models; paths must match and likelihoods agree
+// to 1e-9, on the discrete model and on emission scores spread over thousands
+// of nats (as GMM scores are) with a left-to-right model.
+
+struct BenchmarkOptions {
+    std::vector<int> states = {8, 64, 512};
+    int observations = 64;
+    int frames = 400;
+    bool bakis = false;
+    double beam = 20.0;
+    int max_active = 64;
+    unsigned seed = 1;
+};
+
+// The implementation before the flat layout: vector<vector<double>> parameters,
+// transition_probs[prev_s][s] read column-wise in the inner loop and a fresh
+// vector per forward/backward cell
+class LegacyHMM {
+public:
+    int num_states;
+    int num_observations;
+    std::vector<std::vector<double>> transition_probs;
+    std::vector<std::vector<double>> emission_probs;
+    std::vector<double> initial_probs;
+
+    LegacyHMM(int states, int observations) : num_states(states), num_observations(observations) {
+        transition_probs.resize(num_states, std::vector<double>(num_states, LOG_ZERO));
+        emission_probs.resize(num_states, std::vector<double>(num_observations, LOG_ZERO));
+        initial_probs.resize(num_states, LOG_ZERO);
+    }
+
+    std::vector<int> viterbi(const std::vector<int>& observations) {
+        int T = observations.size();
+        std::vector<std::vector<double>> viterbi_table(T, std::vector<double>(num_states, LOG_ZERO));
+        std::vector<std::vector<int>> path(T, std::vector<int>(num_states, -1));
+        for (int s = 0; s < num_states; s++) {
+            viterbi_table[0][s] = initial_probs[s] + emission_probs[s][observations[0]];
+        }
+        for (int t = 1; t < T; t++) {
+            for (int s = 0; s < num_states; s++) {
+                double max_prob = LOG_ZERO;
+                int best_prev_state = -1;
+                for (int prev_s = 0; prev_s < num_states; prev_s++) {
+                    double prob = viterbi_table[t-1][prev_s] + transition_probs[prev_s][s] + emission_probs[s][observations[t]];
+                    if (prob > max_prob) {
+                        max_prob = prob;
+                        best_prev_state = prev_s;
+                    }
+                }
+                viterbi_table[t][s] = max_prob;
+                path[t][s] = best_prev_state;
+            }
+        }
+        std::vector<int> best_path(T);
+        double max_final_prob = LOG_ZERO;
+        int best_final_state = 0;
+        for (int s = 0; s < num_states; s++) {
+            if (viterbi_table[T-1][s] > max_final_prob) {
+                max_final_prob = viterbi_table[T-1][s];
+                best_final_state = s;
+            }
+        }
+        best_path[T-1] = best_final_state;
+        for (int t = T-2; t >= 0; t--) {
+            best_path[t] = path[t+1][best_path[t+1]];
+        }
+        return best_path;
+    }
+
+    double forward(const std::vector<int>& observations) {
+        int T = observations.size();
+        std::vector<std::vector<double>> alpha(T, std::vector<double>(num_states, LOG_ZERO));
+        for (int s = 0; s < num_states; s++) {
+            alpha[0][s] = initial_probs[s] + emission_probs[s][observations[0]];
+        }
+        for (int t = 1; t < T; t++) {
+            for (int s = 0; s < num_states; s++) {
+                std::vector<double> log_probs;
+                for (int prev_s = 0; prev_s < num_states; prev_s++) {
+                    log_probs.push_back(alpha[t-1][prev_s] + transition_probs[prev_s][s]);
+                }
+                alpha[t][s] = log_sum_exp(log_probs) + emission_probs[s][observations[t]];
+            }
+        }
+        return log_sum_exp(alpha[T-1]);
+    }
+
+    double backward(const std::vector<int>& observations) {
+        int T = observations.size();
+        std::vector<std::vector<double>> beta(T, std::vector<double>(num_states, LOG_ZERO));
+        for (int s = 0; s < num_states; s++) beta[T-1][s] = 0.0;
+        for (int t = T-2; t >= 0; t--) {
+            for (int s = 0; s < num_states; s++) {
+                std::vector<double> log_probs;
+                for (int next_s = 0; next_s < num_states; next_s++) {
+                    log_probs.push_back(transition_probs[s][next_s] + emission_probs[next_s][observations[t+1]] + beta[t+1][next_s]);
+                }
+                beta[t][s] = log_sum_exp(log_probs);
+            }
+        }
+        std::vector<double> initial_backward_probs;
+        for (int s = 0; s < num_states; s++) {
+            initial_backward_probs.push_back(initial_probs[s] + emission_probs[s][observations[0]] + beta[0][s]);
+        }
+        return log_sum_exp(initial_backward_probs);
+    }
+};
+
+// Random row-stochastic model, set identically on both implementations. Bakis
+// models start in state 0 and allow s -> s, s + 1, s + 2.
+static void randomModel(HMM& hmm, LegacyHMM& legacy, bool bakis, std::mt19937& rng) {
+    std::uniform_real_distribution<double> weight(0.05, 1.0);
+    const int S = hmm.numStates();
+    const int O = hmm.numObservations();
+    auto fillRow = [&](int count, std::vector<double>& row) {
+        row.resize(count);
+        double total = 0.0;
+        for (double& p : row) total += (p = weight(rng));
+        for (double& p : row) p /= total;
+    };
+
+    std::vector<double> row;
+    fillRow(S, row);
+    for (int s = 0; s < S; s++) {
+        double p = bakis ? (s == 0 ? 1.0 : 0.0) : row[s];
+        hmm.setInitialProb(s, p);
+        if (p > 0) legacy.initial_probs[s] = log(p);
+    }
+    for (int s = 0; s < S; s++) {
+        int first = bakis ? s : 0;
+        int count = bakis ? std::min(3, S - s) : S;
+        fillRow(count, row);
+        for (int k = 0; k < count; k++) {
+            hmm.setTransitionProb(s, first + k, row[k]);
+            legacy.transition_probs[s][first + k] = log(row[k]);
+        }
+        fillRow(O, row);
+        for (int o = 0; o < O; o++) {
+            hmm.setEmissionProb(s, o, row[o]);
+            legacy.emission_probs[s][o] = log(row[o]);
+        }
+    }
+    hmm.finalizeTopology();
+}
+
+// Run fn repeatedly for at least ~0.2 s; returns microseconds per call
+template <typename Fn>
+static double timeCalls(Fn fn) {
+    int calls = 0;
+    auto start = std::chrono::steady_clock::now();
+    double elapsed = 0.0;
+    do {
+        fn();
+        calls++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < 0.2);
+    return 1e6 * elapsed / calls;
+}
+
+int main(int argc, char** argv) {
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--states" && has_value) options.states = {atoi(argv[++i])};
+        else if (arg == "--observations" && has_value) options.observations = atoi(argv[++i]);
+        else if (arg == "--frames" && has_value) options.frames = atoi(argv[++i]);
+        else if (arg == "--topology" && has_value) options.bakis = std::string(argv[++i]) == "bakis";
+        else if (arg == "--seed" && has_value) options.seed = atoi(argv[++i]);
+        else if (arg == "--beam" && has_value) options.beam = atof(argv[++i]);
+        else if (arg == "--max-active" && has_value) options.max_active = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "Usage: %s [--states N] [--observations N] [--frames N] [--topology dense|bakis] [--seed N]"
+                            " [--beam LOGP] [--max-active N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937 rng(options.seed);
+    printf("%s model, %d frames, %d observation symbols\n", options.bakis ? "Bakis" : "Dense",
+           options.frames, options.observations);
+    printf("%-8s %-10s %14s %14s %10s\n", "states", "kernel", "legacy us", "flat us", "speedup");
+
+    struct BeamRow { int states; double exact_us, beam_us, active, agreement; };
+    std::vector<BeamRow> beam_rows;
+
+    bool agree = true;
+    for (int states : options.states) {
+        HMM hmm(states, options.observations);
+        LegacyHMM legacy(states, options.observations);
+        randomModel(hmm, legacy, options.bakis, rng);
+
+        std::uniform_int_distribution<int> symbol(0, options.observations - 1);
+        std::vector<int> observations(options.frames);
+        for (int& o : observations) o = symbol(rng);
+
+        if (hmm.viterbi(observations) != legacy.viterbi(observations)) {
+            fprintf(stderr, "Viterbi paths differ at %d states\n", states);
+            agree = false;
+        }
+        double likelihoods[] = {hmm.forward(observations), legacy.forward(observations),
+                                hmm.backward(observations), legacy.backward(observations)};
+        for (int k = 1; k < 4; k++) {
+            if (std::abs(likelihoods[k] - likelihoods[0]) > 1e-6 * std::abs(likelihoods[0])) {
+                fprintf(stderr, "Likelihoods differ at %d states: %.10g vs %.10g\n", states, likelihoods[k], likelihoods[0]);
+                agree = false;
+            }
+        }
+
+        struct { const char* name; double legacy_us, flat_us; } rows[] = {
+            {"viterbi", timeCalls([&] { legacy.viterbi(observations); }), timeCalls([&] { hmm.viterbi(observations); })},
+            {"forward", timeCalls([&] { legacy.forward(observations); }), timeCalls([&] { hmm.forward(observations); })},
+            {"backward", timeCalls([&] { legacy.backward(observations); }), timeCalls([&] { hmm.backward(observations); })},
+        };
+        for (const auto& row : rows) {
+            printf("%-8d %-10s %14.1f %14.1f %9.2fx\n", states, row.name, row.legacy_us, row.flat_us, row.legacy_us / row.flat_us);
+        }
+
+        std::vector<int> exact = hmm.viterbi(observations);
+        BeamOptions unpruned;
+        unpruned.beam = std::numeric_limits<double>::infinity();
+        unpruned.max_active = states;
+        if (BeamViterbiDecoder(hmm, unpruned).decode(observations) != exact) {
+            fprintf(stderr, "Unpruned beam path differs from Viterbi at %d states\n", states);
+            agree = false;
+        }
+
+        BeamOptions pruned;
+        pruned.beam = options.beam;
+        pruned.max_active = options.max_active;
+        BeamViterbiDecoder decoder(hmm, pruned);
+        std::vector<int> path = decoder.decode(observations);
+        int matching = 0;
+        for (size_t t = 0; t < path.size(); t++) matching += path[t] == exact[t];
+        beam_rows.push_back({states, timeCalls([&] { hmm.viterbi(observations); }),
+                             timeCalls([&] { decoder.decode(observations); }),
+                             decoder.averageActive(), (double)matching / options.frames});
+    }
+
+    printf("\nBeam %.1f, max active %d\n", options.beam, options.max_active);
+    printf("%-8s %14s %14s %10s %10s %10s\n", "states", "exact us", "beam us", "speedup", "active", "agreement");
+    for (const BeamRow& row : beam_rows) {
+        printf("%-8d %14.1f %14.1f %9.2fx %10.1f %9.1f%%\n", row.states, row.exact_us, row.beam_us,
+               row.exact_us / row.beam_us, row.active, 100.0 * row.agreement);
+    }
+    printf("\nFixed-size kernels\n");
+    printf("%-8s %-10s %14s %14s %10s\n", "states", "kernel", "dynamic us", "fixed us", "speedup");
+    for (int states : {3, 5}) {
+        HMM hmm(states, options.observations);
+        LegacyHMM legacy(states, options.observations);
+        randomModel(hmm, legacy, options.bakis, rng);
+        std::unique_ptr<HMMKernels> fixed = makeHMMKernels(hmm);
+        HMMWorkspace workspace;
+
+        std::uniform_int_distribution<int> symbol(0, options.observations - 1);
+        std::vector<int> observations(options.frames);
+        for (int& o : observations) o = symbol(rng);
+
+        if (fixed->viterbi(observations, workspace) != hmm.viterbi(observations, workspace)) {
+            fprintf(stderr, "Fixed-size Viterbi path differs at %d states\n", states);
+            agree = false;
+        }
+        double exact = hmm.forward(observations, workspace);
+        double scaled = fixed->forward(observations, workspace);
+        if (std::abs(scaled - exact) > 1e-9 * std::abs(exact)) {
+            fprintf(stderr, "Fixed-size likelihood differs at %d states: %.12g vs %.12g\n", states, scaled, exact);
+            agree = false;
+        }
+
+        // Frame 0 only reaches state 0, which scores far below the others
+        HMM bakis(states, options.observations);
+        LegacyHMM bakis_legacy(states, options.observations);
+        randomModel(bakis, bakis_legacy, true, rng);
+        std::unique_ptr<HMMKernels> bakis_fixed = makeHMMKernels(bakis);
+        std::uniform_real_distribution<double> wide(-2000.0, 0.0);
+        std::vector<double> scores((size_t)options.frames * states);
+        for (double& score : scores) score = wide(rng);
+        scores[0] = -1000.0;
+        for (int s = 1; s < states; s++) scores[s] = -10.0;
+        if (bakis_fixed->viterbiScores(scores.data(), options.frames, states, workspace) !=
+            bakis.viterbiScores(scores.data(), options.frames, states, workspace)) {
+            fprintf(stderr, "Fixed-size Viterbi path differs on wide scores at %d states\n", states);
+            agree = false;
+        }
+        exact = bakis.forwardScores(scores.data(), options.frames, states, workspace);
+        scaled = bakis_fixed->forwardScores(scores.data(), options.frames, states, workspace);
+        if (exact == LOG_ZERO || std::abs(scaled - exact) > 1e-9 * std::abs(exact)) {
+            fprintf(stderr, "Fixed-size likelihood differs on wide scores at %d states: %.12g vs %.12g\n", states, scaled, exact);
+            agree = false;
+        }
+
+        struct { const char* name; double dynamic_us, fixed_us; } rows[] = {
+            {"viterbi", timeCalls([&] { hmm.viterbi(observations, workspace); }),
+                        timeCalls([&] { fixed->viterbi(observations, workspace); })},
+            {"forward", timeCalls([&] { hmm.forward(observations, workspace); }),
+                        timeCalls([&] { fixed->forward(observations, workspace); })},
+        };
+        for (const auto& row : rows) {
+            printf("%-8d %-10s %14.1f %14.1f %9.2fx\n", states, row.name, row.dynamic_us, row.fixed_us, row.dynamic_us / row.fixed_us);
+        }
+    }
+    return agree ? 0 : 1;
+}
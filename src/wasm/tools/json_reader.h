@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Small JSON reader for the offline tools (audio manifests, configs). Parses
+// the whole document into a tree; strings are kept as UTF-8.
+
+struct JsonValue {
+    enum Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+    Type type = NUL;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<JsonValue> array;
+    std::vector<std::pair<std::string, JsonValue>> object;   // in document order
+
+    // Member lookup; returns a null value if absent or not an object
+    const JsonValue& operator[](const std::string& key) const {
+        static const JsonValue missing;
+        for (const auto& member : object) {
+            if (member.first == key) return member.second;
+        }
+        return missing;
+    }
+
+    bool isNumber() const { return type == NUMBER; }
+    bool isString() const { return type == STRING; }
+    bool isArray() const { return type == ARRAY; }
+    bool isObject() const { return type == OBJECT; }
+};
+
+class JsonReader {
+private:
+    const std::string& text;
+    size_t pos = 0;
+    std::string error_message;
+
+    void skipSpace() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) pos++;
+    }
+
+    bool fail(const char* message) {
+        if (error_message.empty()) error_message = std::string(message) + " at offset " + std::to_string(pos);
+        return false;
+    }
+
+    bool literal(const char* word) {
+        size_t length = strlen(word);
+        if (text.compare(pos, length, word) != 0) return fail("invalid literal");
+        pos += length;
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, unsigned code) {
+        if (code < 0x80) {
+            out += (char)code;
+        } else if (code < 0x800) {
+            out += (char)(0xC0 | (code >> 6));
+            out += (char)(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += (char)(0xE0 | (code >> 12));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        } else {
+            out += (char)(0xF0 | (code >> 18));
+            out += (char)(0x80 | ((code >> 12) & 0x3F));
+            out += (char)(0x80 | ((code >> 6) & 0x3F));
+            out += (char)(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool hex4(unsigned& code) {
+        if (pos + 4 > text.size()) return fail("truncated escape");
+        code = strtoul(text.substr(pos, 4).c_str(), nullptr, 16);
+        pos += 4;
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        pos++;  // opening quote
+        while (pos < text.size() && text[pos] != '"') {
+            char c = text[pos++];
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (pos >= text.size()) return fail("truncated escape");
+            char e = text[pos++];
+            switch (e) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    unsigned code = 0;
+                    if (!hex4(code)) return false;
+                    if (code >= 0xD800 && code < 0xDC00 && text.compare(pos, 2, "\\u") == 0) {
+                        unsigned low = 0;
+                        pos += 2;
+                        if (!hex4(low)) return false;
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default: out += e; break;   // \" \\ \/
+            }
+        }
+        if (pos >= text.size()) return fail("unterminated string");
+        pos++;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth) {
+        if (depth > 64) return fail("nesting too deep");
+        skipSpace();
+        if (pos >= text.size()) return fail("unexpected end of input");
+
+        char c = text[pos];
+        if (c == '{') {
+            value.type = JsonValue::OBJECT;
+            pos++;
+            skipSpace();
+            if (pos < text.size() && text[pos] == '}') { pos++; return true; }
+            while (true) {
+                skipSpace();
+                if (pos >= text.size() || text[pos] != '"') return fail("expected member name");
+                std::pair<std::string, JsonValue> member;
+                if (!parseString(member.first)) return false;
+                skipSpace();
+                if (pos >= text.size() || text[pos] != ':') return fail("expected ':'");
+                pos++;
+                if (!parseValue(member.second, depth + 1)) return false;
+                value.object.push_back(std::move(member));
+                skipSpace();
+                if (pos < text.size() && text[pos] == ',') { pos++; continue; }
+                if (pos < text.size() && text[pos] == '}') { pos++; return true; }
+                return fail("expected ',' or '}'");
+            }
+        }
+        if (c == '[') {
+            value.type = JsonValue::ARRAY;
+            pos++;
+            skipSpace();
+            if (pos < text.size() && text[pos] == ']') { pos++; return true; }
+            while (true) {
+                value.array.emplace_back();
+                if (!parseValue(value.array.back(), depth + 1)) return false;
+                skipSpace();
+                if (pos < text.size() && text[pos] == ',') { pos++; continue; }
+                if (pos < text.size() && text[pos] == ']') { pos++; return true; }
+                return fail("expected ',' or ']'");
+            }
+        }
+        if (c == '"') {
+            value.type = JsonValue::STRING;
+            return parseString(value.string);
+        }
+        if (c == 't') { value.type = JsonValue::BOOLEAN; value.boolean = true; return literal("true"); }
+        if (c == 'f') { value.type = JsonValue::BOOLEAN; return literal("false"); }
+        if (c == 'n') { return literal("null"); }
+
+        const char* start = text.c_str() + pos;
+        char* end;
+        value.number = strtod(start, &end);
+        if (end == start) return fail("unexpected character");
+        value.type = JsonValue::NUMBER;
+        pos += end - start;
+        return true;
+    }
+
+public:
+    explicit JsonReader(const std::string& source) : text(source) {}
+
+    bool parse(JsonValue& root) {
+        if (!parseValue(root, 0)) return false;
+        skipSpace();
+        return pos == text.size() || fail("trailing characters");
+    }
+
+    const std::string& error() const { return error_message; }
+};
@@ -0,0 +1,196 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "../dtw.h"
+#include "../dtw_quantized.h"
+#include "../feature_store.h"
+
+// Accuracy and speed of the quantized DTW kernels against the double version.
+//
+// Every query is aligned against every reference with computeDTWBounded (double)
+// and with computeDTWQuantized at int8 and int16. Reported per precision: the
+// relative distance error, how often the nearest reference changes, and the
+// time per alignment. Quantization parameters are fitted on the references.
+//
+// The corpus is the verses of a reference feature store (--store), each verse
+// queried with a time-warped, noisy copy of itself. Without a store a synthetic
+// MFCC-like corpus is generated.
+
+struct ReportOptions {
+    std::string store;
+    int references = 200;
+    int queries = 50;
+    int band = -1;
+    unsigned seed = 1;
+};
+
+// Smooth random trajectories with MFCC-like ranges: c0 wide, higher coefficients narrow
+static std::vector<FeatureMatrix> syntheticCorpus(int count, std::mt19937& rng) {
+    const int dims = 13;
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::uniform_int_distribution<int> length(80, 200);
+
+    std::vector<FeatureMatrix> corpus;
+    for (int k = 0; k < count; k++) {
+        std::vector<std::vector<double>> frames(length(rng), std::vector<double>(dims));
+        std::vector<double> level(dims);
+        for (int d = 0; d < dims; d++) level[d] = noise(rng) * (d == 0 ? 40.0 : 12.0 / (1 + d));
+        for (auto& frame : frames) {
+            for (int d = 0; d < dims; d++) {
+                level[d] += noise(rng) * (d == 0 ? 4.0 : 1.5 / (1 + d));
+                frame[d] = level[d];
+            }
+        }
+        corpus.push_back(toFeatureMatrix(frames));
+    }
+    return corpus;
+}
+
+static bool storeCorpus(const std::string& path, int count, std::vector<FeatureMatrix>& corpus) {
+    FeatureStore store;
+    std::string error;
+    if (!store.openFile(path, &error)) {
+        fprintf(stderr, "Cannot open %s: %s\n", path.c_str(), error.c_str());
+        return false;
+    }
+    if (store.payloadType() == PAYLOAD_INT8) {
+        fprintf(stderr, "Note: %s has an int8 payload, so the double baseline is itself dequantized\n", path.c_str());
+    }
+
+    for (uint32_t v = 0; v < store.verseCount() && (int)corpus.size() < count; v++) {
+        const VerseEntry* verse = store.verseAt(v);
+        if (verse->frame_count > 0) {
+            corpus.push_back(store.frames(verse->frame_offset, verse->frame_count));
+        }
+    }
+    return !corpus.empty();
+}
+
+// Resample in time by a random factor and add noise, so the query is closest to its source
+static FeatureMatrix perturb(const FeatureMatrix& source, std::mt19937& rng) {
+    std::uniform_real_distribution<double> stretch(0.8, 1.25);
+    std::normal_distribution<double> noise(0.0, 0.5);
+    int rows = std::max(1, (int)std::lround(source.rows * stretch(rng)));
+
+    std::vector<std::vector<double>> frames(rows, std::vector<double>(source.dims));
+    for (int i = 0; i < rows; i++) {
+        const double* frame = source.row(std::min(source.rows - 1, (int)((long)i * source.rows / rows)));
+        for (int d = 0; d < source.dims; d++) {
+            frames[i][d] = frame[d] + noise(rng);
+        }
+    }
+    return toFeatureMatrix(frames);
+}
+
+struct PrecisionStats {
+    const char* name;
+    double error_sum = 0.0;
+    double error_max = 0.0;
+    long compared = 0;
+    int nearest_changed = 0;
+    double seconds = 0.0;
+};
+
+template <typename T>
+static void measure(const std::vector<FeatureMatrix>& queries,
+                    const std::vector<FeatureMatrix>& references,
+                    const std::vector<std::vector<double>>& exact,
+                    const std::vector<int>& exact_nearest,
+                    int band, PrecisionStats& stats) {
+    std::vector<const FeatureMatrix*> corpus;
+    for (const FeatureMatrix& reference : references) corpus.push_back(&reference);
+    QuantizationParams params = fitQuantization<T>(corpus);
+
+    std::vector<QuantizedMatrix<T>> quantized_refs;
+    for (const FeatureMatrix& reference : references) quantized_refs.push_back(quantizeFeatures<T>(reference, params));
+
+    DTWWorkspace workspace;
+    for (size_t q = 0; q < queries.size(); q++) {
+        QuantizedMatrix<T> query = quantizeFeatures<T>(queries[q], params);
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<double> distances(references.size());
+        for (size_t r = 0; r < references.size(); r++) {
+            distances[r] = computeDTWQuantized(query.data.data(), query.rows,
+                                               quantized_refs[r].data.data(), quantized_refs[r].rows,
+                                               params, DTW_EXCEEDS_BOUND, band, workspace);
+        }
+        stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        int nearest = 0;
+        for (size_t r = 0; r < references.size(); r++) {
+            if (distances[r] < distances[nearest]) nearest = r;
+            if (std::isfinite(exact[q][r]) && exact[q][r] > 0) {
+                double error = std::abs(distances[r] - exact[q][r]) / exact[q][r];
+                stats.error_sum += error;
+                stats.error_max = std::max(stats.error_max, error);
+                stats.compared++;
+            }
+        }
+        if (nearest != exact_nearest[q]) stats.nearest_changed++;
+    }
+}
+
+int main(int argc, char** argv) {
+    ReportOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--store" && has_value) options.store = argv[++i];
+        else if (arg == "--references" && has_value) options.references = atoi(argv[++i]);
+        else if (arg == "--queries" && has_value) options.queries = atoi(argv[++i]);
+        else if (arg == "--band" && has_value) options.band = atoi(argv[++i]);
+        else if (arg == "--seed" && has_value) options.seed = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "Usage: %s [--store PATH] [--references N] [--queries N] [--band N] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::mt19937 rng(options.seed);
+    std::vector<FeatureMatrix> references;
+    if (options.store.empty()) {
+        references = syntheticCorpus(options.references, rng);
+    } else if (!storeCorpus(options.store, options.references, references)) {
+        return 1;
+    }
+
+    std::vector<FeatureMatrix> queries;
+    std::uniform_int_distribution<int> pick(0, references.size() - 1);
+    for (int q = 0; q < options.queries; q++) {
+        queries.push_back(perturb(references[pick(rng)], rng));
+    }
+
+    // Double-precision baseline
+    std::vector<std::vector<double>> exact(queries.size(), std::vector<double>(references.size()));
+    std::vector<int> exact_nearest(queries.size(), 0);
+    DTWWorkspace workspace;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < queries.size(); q++) {
+        for (size_t r = 0; r < references.size(); r++) {
+            exact[q][r] = computeDTWBounded(queries[q], references[r], DTW_EXCEEDS_BOUND, options.band, EUCLIDEAN, workspace);
+            if (exact[q][r] < exact[q][exact_nearest[q]]) exact_nearest[q] = r;
+        }
+    }
+    double double_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    PrecisionStats int8_stats{"int8"}, int16_stats{"int16"};
+    measure<int8_t>(queries, references, exact, exact_nearest, options.band, int8_stats);
+    measure<int16_t>(queries, references, exact, exact_nearest, options.band, int16_stats);
+
+    long alignments = (long)queries.size() * references.size();
+    printf("Corpus: %s, %zu references, %zu queries, band %d\n",
+           options.store.empty() ? "synthetic" : options.store.c_str(), references.size(), queries.size(), options.band);
+    printf("%-8s %14s %14s %16s %14s\n", "type", "mean rel err", "max rel err", "nearest changed", "us/align");
+    printf("%-8s %14s %14s %16s %14.1f\n", "double", "-", "-", "-", 1e6 * double_seconds / alignments);
+    for (const PrecisionStats* stats : {&int8_stats, &int16_stats}) {
+        printf("%-8s %14.2e %14.2e %9d / %-5zu %14.1f\n", stats->name,
+               stats->compared ? stats->error_sum / stats->compared : 0.0, stats->error_max,
+               stats->nearest_changed, queries.size(), 1e6 * stats->seconds / alignments);
+    }
+    return 0;
+}
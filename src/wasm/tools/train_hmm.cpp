@@ -0,0 +1,275 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../audio_processor.h"
+#include "../feature_config.h"
+#include "../hmm_model_file.h"
+#include "../hmm_training.h"
+#include "../thread_pool.h"
+#include "wav_reader.h"
+
+// Offline GMM-HMM trainer
+//
+// Trains one left-to-right HMM with diagonal-covariance GMM emissions per label
+// (phoneme, word, ...) from labeled recordings, using the MFCC front end of
+// the browser (audio_processor.cpp). Feature extraction and the Baum-Welch
+// E-step both run on all cores.
+//
+// The corpus file lists one recording per line, "<label> <path.wav>", with
+// paths relative to the corpus file; labels cannot contain / or \. Blank lines
+// and lines starting with # are skipped. The models are written as JSON, one
+// entry per label, with plain probabilities (initial, transitions [from][to],
+// weights, means, variances) and the log-likelihood per frame of the final model.
+// With --models-dir each model is also written as <label>.bqhm in the binary
+// model format (hmm_model_file.h), which the browser loads in one call.
+
+struct TrainOptions {
+    std::string corpus;
+    std::string output = "phoneme_models.json";
+    std::string models_dir;
+    int states = 3;
+    int components = 2;
+    int iterations = 20;
+    int frame_length = 2048;        // WasmAnalysisService bufferSize
+    int hop_size = 512;             // WasmAnalysisService hopSize
+    int threads = 0;
+    bool ergodic = false;
+};
+
+static void printUsage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s --corpus FILE [options]\n"
+            "  --corpus FILE        lines of \"<label> <path.wav>\"\n"
+            "  --output PATH        models to write (default phoneme_models.json)\n"
+            "  --models-dir DIR     also write one binary <label>.bqhm per model\n"
+            "  --states N           emitting states per model (default 3)\n"
+            "  --components N       Gaussians per state (default 2)\n"
+            "  --iterations N       maximum Baum-Welch iterations (default 20)\n"
+            "  --frame-length N     analysis frame in samples (default 2048)\n"
+            "  --hop N              hop between frames in samples (default 512)\n"
+            "  --threads N          worker threads (default: all cores)\n"
+            "  --ergodic            allow every transition instead of left-to-right\n",
+            program);
+}
+
+static bool parseOptions(int argc, char** argv, TrainOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--corpus" && has_value) options.corpus = argv[++i];
+        else if (arg == "--output" && has_value) options.output = argv[++i];
+        else if (arg == "--models-dir" && has_value) options.models_dir = argv[++i];
+        else if (arg == "--states" && has_value) options.states = atoi(argv[++i]);
+        else if (arg == "--components" && has_value) options.components = atoi(argv[++i]);
+        else if (arg == "--iterations" && has_value) options.iterations = atoi(argv[++i]);
+        else if (arg == "--frame-length" && has_value) options.frame_length = atoi(argv[++i]);
+        else if (arg == "--hop" && has_value) options.hop_size = atoi(argv[++i]);
+        else if (arg == "--threads" && has_value) options.threads = atoi(argv[++i]);
+        else if (arg == "--ergodic") options.ergodic = true;
+        else return false;
+    }
+    return !options.corpus.empty() && options.states > 0 && options.components > 0 &&
+           options.frame_length > 0 && options.hop_size > 0;
+}
+
+struct Recording {
+    std::string label;
+    std::string path;
+};
+
+static bool readCorpus(const std::string& corpus_path, std::vector<Recording>& recordings) {
+    std::ifstream file(corpus_path);
+    if (!file) {
+        fprintf(stderr, "Cannot read corpus %s\n", corpus_path.c_str());
+        return false;
+    }
+    size_t slash = corpus_path.find_last_of('/');
+    std::string base = slash == std::string::npos ? "" : corpus_path.substr(0, slash + 1);
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        Recording recording;
+        if (!(fields >> recording.label) || recording.label[0] == '#') continue;
+        // Labels name the --models-dir files, so they must not leave that directory
+        if (recording.label.find_first_of("/\\") != std::string::npos ||
+            recording.label == "." || recording.label == "..") {
+            fprintf(stderr, "Invalid label \"%s\" in %s: labels cannot contain path separators\n",
+                    recording.label.c_str(), corpus_path.c_str());
+            return false;
+        }
+        fields >> std::ws;
+        std::getline(fields, recording.path);
+        if (recording.path.empty()) continue;
+        if (recording.path[0] != '/') recording.path = base + recording.path;
+        recordings.push_back(recording);
+    }
+    return true;
+}
+
+static void writeArray(std::ostream& out, const double* values, int count) {
+    out << "[";
+    for (int i = 0; i < count; i++) {
+        char number[32];
+        snprintf(number, sizeof(number), "%.9g", values[i]);
+        out << (i ? ", " : "") << number;
+    }
+    out << "]";
+}
+
+// rows x columns as nested arrays
+static void writeMatrix(std::ostream& out, const double* values, int rows, int columns) {
+    out << "[";
+    for (int r = 0; r < rows; r++) {
+        out << (r ? ", " : "");
+        writeArray(out, values + (size_t)r * columns, columns);
+    }
+    out << "]";
+}
+
+struct TrainedModel {
+    GMMHMMParameters parameters;
+    int utterances = 0;
+    double log_likelihood = 0.0;
+    int iterations = 0;
+};
+
+static bool writeModels(const std::string& path, const std::map<std::string, TrainedModel>& models,
+                        const TrainOptions& options, uint64_t config_hash) {
+    std::ofstream out(path);
+    out << "{\n  \"configHash\": \"" << featureConfigHashHex(config_hash) << "\",\n"
+        << "  \"states\": " << options.states << ",\n"
+        << "  \"components\": " << options.components << ",\n"
+        << "  \"dims\": " << NUM_MFCC_COEFFS << ",\n"
+        << "  \"models\": {";
+
+    bool first = true;
+    for (const auto& entry : models) {
+        const GMMHMMParameters& p = entry.second.parameters;
+        const int SK = p.states * p.components;
+        out << (first ? "\n" : ",\n") << "    \"" << entry.first << "\": {\n"
+            << "      \"utterances\": " << entry.second.utterances << ",\n"
+            << "      \"iterations\": " << entry.second.iterations << ",\n"
+            << "      \"logLikelihoodPerFrame\": " << entry.second.log_likelihood << ",\n"
+            << "      \"initial\": ";
+        writeArray(out, p.initial.data(), p.states);
+        out << ",\n      \"transitions\": ";
+        writeMatrix(out, p.transitions.data(), p.states, p.states);
+        out << ",\n      \"weights\": ";
+        writeMatrix(out, p.weights.data(), p.states, p.components);
+        out << ",\n      \"means\": ";
+        writeMatrix(out, p.means.data(), SK, p.dims);
+        out << ",\n      \"variances\": ";
+        writeMatrix(out, p.variances.data(), SK, p.dims);
+        out << "\n    }";
+        first = false;
+    }
+    out << "\n  }\n}\n";
+    return static_cast<bool>(out);
+}
+
+static bool writeBinaryModels(const std::string& dir, const std::map<std::string, TrainedModel>& models,
+                              uint64_t config_hash) {
+    for (const auto& entry : models) {
+        const GMMHMMParameters& p = entry.second.parameters;
+        HMMModelMixtures mixtures;
+        mixtures.components = p.components;
+        mixtures.dims = p.dims;
+        mixtures.weights = p.weights.data();
+        mixtures.means = p.means.data();
+        mixtures.variances = p.variances.data();
+        std::vector<uint8_t> bytes = serializeHMMModel(p.buildHMM(), &mixtures, config_hash);
+
+        std::string path = dir + "/" + entry.first + ".bqhm";
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        if (!out) {
+            fprintf(stderr, "Cannot write %s\n", path.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    TrainOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Recording> recordings;
+    if (!readCorpus(options.corpus, recordings)) {
+        return 1;
+    }
+
+    ThreadPool pool(options.threads);
+    fprintf(stderr, "%zu recordings, extracting features on %d threads\n", recordings.size(), pool.size());
+
+    std::vector<TrainingUtterance> features(recordings.size());
+    std::vector<std::string> errors(recordings.size());
+    pool.parallelFor(recordings.size(), [&](int k) {
+        WavAudio audio;
+        std::string error;
+        if (!readWavFile(recordings[k].path, audio, &error)) {
+            errors[k] = error;
+            return;
+        }
+        auto samples = resampleLinear(audio.samples, audio.sample_rate, SAMPLE_RATE);
+        auto frames = computeMFCCFrames(samples, options.frame_length, options.hop_size);
+        if ((int)frames.size() < options.states) {
+            errors[k] = "fewer frames than states";
+            return;
+        }
+        TrainingUtterance& utterance = features[k];
+        utterance.rows = frames.size();
+        for (const auto& frame : frames) {
+            utterance.frames.insert(utterance.frames.end(), frame.begin(), frame.end());
+        }
+    });
+
+    std::map<std::string, std::vector<TrainingUtterance>> by_label;
+    for (size_t k = 0; k < recordings.size(); k++) {
+        if (!errors[k].empty()) {
+            fprintf(stderr, "  skipped %s: %s\n", recordings[k].path.c_str(), errors[k].c_str());
+            continue;
+        }
+        by_label[recordings[k].label].push_back(std::move(features[k]));
+    }
+
+    BaumWelchOptions train_options;
+    train_options.iterations = options.iterations;
+
+    std::map<std::string, TrainedModel> models;
+    for (const auto& entry : by_label) {
+        TrainedModel model;
+        model.parameters = flatStartParameters(entry.second, options.states, options.components, NUM_MFCC_COEFFS,
+                                               !options.ergodic, train_options.variance_floor);
+        std::vector<double> history = trainBaumWelch(model.parameters, entry.second, pool, train_options);
+        model.utterances = entry.second.size();
+        model.iterations = history.size();
+        // The history scores each iteration's input; score the final parameters
+        model.log_likelihood = history.empty() ? LOG_ZERO : averageLogLikelihood(model.parameters, entry.second, pool);
+        fprintf(stderr, "  %-12s %4d utterances, %2d iterations, log-likelihood/frame %.4f\n",
+                entry.first.c_str(), model.utterances, model.iterations, model.log_likelihood);
+        models[entry.first] = std::move(model);
+    }
+
+    const uint64_t config_hash = featureConfigHash(frontEndConfig(options.frame_length, options.hop_size));
+    if (!writeModels(options.output, models, options, config_hash)) {
+        fprintf(stderr, "Cannot write %s\n", options.output.c_str());
+        return 1;
+    }
+    fprintf(stderr, "Wrote %zu models to %s\n", models.size(), options.output.c_str());
+    if (!options.models_dir.empty()) {
+        if (!writeBinaryModels(options.models_dir, models, config_hash)) {
+            return 1;
+        }
+        fprintf(stderr, "Wrote binary models to %s\n", options.models_dir.c_str());
+    }
+    return 0;
+}
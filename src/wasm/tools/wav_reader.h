@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Minimal RIFF/WAVE reader for the offline tools: PCM 8/16/24/32-bit and
+// IEEE float 32/64-bit, any channel count. Channels are averaged to mono and
+// samples scaled to [-1, 1], matching what the Web Audio API hands the app.
+
+struct WavAudio {
+    double sample_rate = 0;
+    std::vector<double> samples;
+};
+
+inline uint32_t wavReadU32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+inline uint16_t wavReadU16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+
+inline bool readWavFile(const std::string& path, WavAudio& audio, std::string* error = nullptr) {
+    auto fail = [error](const char* message) {
+        if (error) *error = message;
+        return false;
+    };
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return fail("cannot open file");
+    std::vector<uint8_t> bytes;
+    uint8_t chunk[65536];
+    size_t got;
+    while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        bytes.insert(bytes.end(), chunk, chunk + got);
+    }
+    fclose(file);
+
+    if (bytes.size() < 12 || memcmp(bytes.data(), "RIFF", 4) != 0 || memcmp(bytes.data() + 8, "WAVE", 4) != 0) {
+        return fail("not a RIFF/WAVE file");
+    }
+
+    int format = 0, channels = 0, bits = 0;
+    uint32_t rate = 0;
+    const uint8_t* data = nullptr;
+    size_t data_size = 0;
+
+    size_t pos = 12;
+    while (pos + 8 <= bytes.size()) {
+        const uint8_t* id = bytes.data() + pos;
+        size_t size = wavReadU32(id + 4);
+        size_t body = pos + 8;
+        size_t available = std::min(size, bytes.size() - body);
+
+        if (memcmp(id, "fmt ", 4) == 0 && available >= 16) {
+            format = wavReadU16(id + 8);
+            channels = wavReadU16(id + 10);
+            rate = wavReadU32(id + 12);
+            bits = wavReadU16(id + 22);
+            if (format == 0xFFFE && available >= 26) {
+                format = wavReadU16(id + 32);   // WAVE_FORMAT_EXTENSIBLE sub-format
+            }
+        } else if (memcmp(id, "data", 4) == 0) {
+            data = bytes.data() + body;
+            data_size = available;           // tolerate a truncated final chunk
+        }
+        pos = body + size + (size & 1);
+    }
+
+    if (!data || channels <= 0 || rate == 0) return fail("missing fmt or data chunk");
+    bool is_pcm = format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32);
+    bool is_float = format == 3 && (bits == 32 || bits == 64);
+    if (!is_pcm && !is_float) return fail("unsupported sample format");
+
+    int sample_bytes = bits / 8;
+    size_t frames = data_size / ((size_t)sample_bytes * channels);
+    audio.sample_rate = rate;
+    audio.samples.assign(frames, 0.0);
+
+    for (size_t i = 0; i < frames; i++) {
+        double sum = 0.0;
+        for (int c = 0; c < channels; c++) {
+            const uint8_t* p = data + (i * channels + c) * sample_bytes;
+            double value;
+            if (is_float && bits == 32) {
+                float f;
+                memcpy(&f, p, 4);
+                value = f;
+            } else if (is_float) {
+                memcpy(&value, p, 8);
+            } else if (bits == 8) {
+                value = (p[0] - 128) / 128.0;
+            } else if (bits == 16) {
+                value = (int16_t)wavReadU16(p) / 32768.0;
+            } else if (bits == 24) {
+                int32_t v = (int32_t)((uint32_t)p[0] << 8 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 24) >> 8;
+                value = v / 8388608.0;
+            } else {
+                value = (int32_t)wavReadU32(p) / 2147483648.0;
+            }
+            sum += value;
+        }
+        audio.samples[i] = sum / channels;
+    }
+    return true;
+}
+
+// Linear-interpolation resampling, enough to bring reference recordings to the
+// front end's fixed analysis rate
+inline std::vector<double> resampleLinear(const std::vector<double>& samples, double from_rate, double to_rate) {
+    if (from_rate == to_rate || samples.empty()) {
+        return samples;
+    }
+    size_t count = (size_t)((double)samples.size() * to_rate / from_rate);
+    std::vector<double> out(count);
+    double step = from_rate / to_rate;
+    for (size_t i = 0; i < count; i++) {
+        double position = i * step;
+        size_t k = (size_t)position;
+        double frac = position - k;
+        double next = k + 1 < samples.size() ? samples[k + 1] : samples[k];
+        out[i] = samples[k] + (next - samples[k]) * frac;
+    }
+    return out;
+}